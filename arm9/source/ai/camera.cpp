@@ -1,6 +1,7 @@
 #include "ai/camera.h"
 #include "ai/captain.h"
 #include "render/multipass_renderer.h"
+#include "input_utils.h"
 #include "numeric_types.h"
 #include "pikmin_game.h"
 
@@ -92,19 +93,19 @@ void UpdateLazyFollowCamera(CameraState& camera) {
 }
 
 bool FocusCursorPressed(const CameraState& camera) {
-  return (keysDown() & KEY_L);
+  return (input::Down() & KEY_L);
 }
 
 bool FocusCursorReleased(const CameraState& camera) {
-  return !(keysHeld() & KEY_L);
+  return !(input::Held() & KEY_L);
 }
 
 bool ZoomPressed(const CameraState& camera) {
-  return (keysDown() & KEY_R);
+  return (input::Down() & KEY_R);
 }
 
 bool HeightPressed(const CameraState& camera) {
-  return (keysDown() & KEY_X);
+  return (input::Down() & KEY_X);
 }
 
 void CenterBehindSubject(CameraState& camera) {
@@ -8,6 +8,7 @@
 #include "pikmin_game.h"
 #include "sfx.h"
 #include "trig.h"
+#include "vector_kernels.h"
 
 using numeric_types::literals::operator"" _f;
 using numeric_types::literals::operator"" _brad;
@@ -27,25 +28,38 @@ const fixed kPikminThrowHeight = 1.8_f;
 const fixed kYellowPikminThrowHeight = 2.2_f;
 const int kWhistleExpandFrames = 8;
 
-void HandleWhistle(CaptainState& captain) {
-  captain.whistle_body->position = captain.cursor_body->position;
+const fixed kWhistleHeight = 20_f;
+const int kMaxWhistledPikmin = 100;
 
+void HandleWhistle(CaptainState& captain) {
   // Do a bit of cheating and handle the whistle here for now
-  if (keysHeld() & KEY_B) {
+  bool whistle_on = input::Held() & KEY_B;
+  if (whistle_on) {
     if (captain.whistle_timer < 8) {
       captain.whistle_timer++;
-      //turn the whistle on
-      captain.whistle_body->collision_group = WHISTLE_GROUP;
     }
   } else if (captain.whistle_timer > 0) {
     captain.whistle_timer--;
-    //turn the whistle back off
-    captain.whistle_body->collision_group = 0;
   }
 
-  captain.whistle_body->radius = fixed::FromInt(captain.whistle_timer) * 10_f / fixed::FromInt(kWhistleExpandFrames);
-  captain.whistle->set_scale(fixed::FromInt(captain.whistle_timer) * 10_f / fixed::FromInt(kWhistleExpandFrames));
+  fixed whistle_radius = fixed::FromInt(captain.whistle_timer) * 10_f / fixed::FromInt(kWhistleExpandFrames);
+  captain.whistle->set_scale(whistle_radius);
   captain.whistle->set_rotation(0_brad, captain.whistle->rotation().y + 3_brad, 0_brad);
+
+  // Let every pikmin under the whistle know it was called this frame
+  if (whistle_on) {
+    physics::Body* whistled[kMaxWhistledPikmin];
+    int count = captain.world().QueryCylinder(captain.cursor_body->position,
+        whistle_radius, kWhistleHeight, PIKMIN_GROUP, whistled,
+        kMaxWhistledPikmin);
+    for (int i = 0; i < count; i++) {
+      PikminState* pikmin = captain.game->RetrievePikmin(whistled[i]->owner);
+      if (pikmin) {
+        pikmin->whistled_by = captain.handle;
+        pikmin->whistled_frame = captain.game->CurrentFrame();
+      }
+    }
+  }
 }
 
 void InitAlways(CaptainState& captain) {
@@ -76,19 +90,13 @@ void InitAlways(CaptainState& captain) {
 
   //Initialize the whistle
   captain.whistle->set_actor(captain.game->ActorAllocator()->Retrieve("whistle"));
-  captain.whistle_body = captain.game->world().AllocateBody();
-
-  captain.whistle_body->height = 20.0_f;
-  captain.whistle_body->is_sensor = 1;
-  captain.whistle_body->owner = captain.handle;
-  captain.whistle_body->is_very_important = 1;
 }
 
 bool DpadActive(const CaptainState& captain) {
-  return (keysHeld() & KEY_RIGHT) or
-         (keysHeld() & KEY_LEFT) or
-         (keysHeld() & KEY_UP) or
-         (keysHeld() & KEY_DOWN);
+  return (input::Held() & KEY_RIGHT) or
+         (input::Held() & KEY_LEFT) or
+         (input::Held() & KEY_UP) or
+         (input::Held() & KEY_DOWN);
 }
 
 bool DpadInactive(const CaptainState& captain) {
@@ -127,9 +135,10 @@ void MoveCaptain(CaptainState& captain) {
   // Clamp the cursor to a certain distance from the captain
   Vec2 captain_xz = Vec2{captain.body->position.x, captain.body->position.z};
   Vec2 cursor_xz = Vec2{captain.cursor_body->position.x, captain.cursor_body->position.z};
-  fixed distance = (cursor_xz - captain_xz).Length();
+  Vec2 direction;
+  fixed distance = vector_kernels::LengthAndDirection(cursor_xz - captain_xz, &direction);
   if (distance > kCursorMaxDistance) {
-    cursor_xz = (cursor_xz - captain_xz).Normalize() * kCursorMaxDistance;
+    cursor_xz = direction * kCursorMaxDistance;
     cursor_xz += captain_xz;
     captain.cursor_body->position.x = cursor_xz.x;
     captain.cursor_body->position.z = cursor_xz.y;
@@ -158,7 +167,7 @@ void MoveCaptain(CaptainState& captain) {
 }
 
 bool ActionDownNearPikmin(const CaptainState& captain) {
-  if (keysDown() & KEY_A and captain.squad.squad_size > 0 and !(captain.active_onion)) {
+  if (input::Down() & KEY_A and captain.squad.squad_size > 0 and !(captain.active_onion)) {
     //todo: check for proximity? this will work for now I guess
     return true;
   }
@@ -166,7 +175,7 @@ bool ActionDownNearPikmin(const CaptainState& captain) {
 }
 
 bool ActionReleased(const CaptainState& captain) {
-  return (keysUp() & KEY_A);
+  return (input::Up() & KEY_A);
 }
 
 void GrabPikmin(CaptainState& captain) {
@@ -212,9 +221,9 @@ void ThrowPikmin(CaptainState& captain) {
 }
 
 bool RedButtonPressed(const CaptainState& captain) {
-  if (keysDown() & KEY_TOUCH) {
+  if (input::Down() & KEY_TOUCH) {
     touchPosition touch;
-    touchRead(&touch);
+    touch = input::Touch();
 
     if (touch.px < 40 and touch.py < 64) {
       return true;
@@ -224,9 +233,9 @@ bool RedButtonPressed(const CaptainState& captain) {
 }
 
 bool YellowButtonPressed(const CaptainState& captain) {
-  if (keysDown() & KEY_TOUCH) {
+  if (input::Down() & KEY_TOUCH) {
     touchPosition touch;
-    touchRead(&touch);
+    touch = input::Touch();
 
     if (touch.px < 40 and touch.py >= 64 and touch.py < 128) {
       return true;
@@ -236,9 +245,9 @@ bool YellowButtonPressed(const CaptainState& captain) {
 }
 
 bool BlueButtonPressed(const CaptainState& captain) {
-  if (keysDown() & KEY_TOUCH) {
+  if (input::Down() & KEY_TOUCH) {
     touchPosition touch;
-    touchRead(&touch);
+    touch = input::Touch();
 
     if (touch.px < 40 and touch.py >= 128) {
       return true;
@@ -260,7 +269,7 @@ void SwitchTo(CaptainState& captain) {
 }
 
 bool DismissPressedWithSquad(const CaptainState& captain) {
-  if ((keysDown() & KEY_Y) and captain.squad.squad_size > 0) {
+  if ((input::Down() & KEY_Y) and captain.squad.squad_size > 0) {
     return true;
   }
   return false;
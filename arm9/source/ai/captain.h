@@ -17,7 +17,6 @@ struct CaptainState : PikminGameState {
   pikmin_ai::PikminState* held_pikmin;
   Drawable* cursor;
   Drawable* whistle;
-  physics::Body* whistle_body;
   physics::Body* cursor_body;
   int whistle_timer = 0;
   squad_ai::SquadState squad;
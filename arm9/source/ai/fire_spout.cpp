@@ -19,18 +19,11 @@ void InitAlways(FireSpoutState& fire_spout) {
   fire_spout.entity->set_actor(fire_spout.game->ActorAllocator()->Retrieve("fire_spout"));
 
   // Set our initial timer to something appropriate
-  fire_spout.flame_timer = (rand() % 128);
+  fire_spout.flame_timer = fire_spout.random.Range(128);
 
   // Setup our static physics properties
   fire_spout.body->collision_group = ATTACK_GROUP;
 
-  fire_spout.detection = fire_spout.world().AllocateBody(fire_spout.handle);
-  fire_spout.detection->position = fire_spout.position();
-  fire_spout.detection->radius = 10_f;
-  fire_spout.detection->height = 5_f;
-  fire_spout.detection->is_sensor = true;
-  fire_spout.detection->collision_group = DETECT_GROUP;
-
   auto health_state = fire_spout.game->RetrieveHealth(fire_spout.game->SpawnHealth());
   if (!health_state) {
     fire_spout.dead = true;
@@ -56,7 +49,7 @@ void FlameOff(FireSpoutState& fire_spout) {
   fire_spout.world().FreeBody(fire_spout.flame_sensor);
   fire_spout.flame_sensor = nullptr;
 
-  fire_spout.flame_timer = (rand() % 16) + 112;
+  fire_spout.flame_timer = fire_spout.random.Range(16) + 112;
 }
 
 bool FlameTimerExpired(const FireSpoutState& fire_spout) {
@@ -71,9 +64,10 @@ void SpawnFireParticle(FireSpoutState& fire_spout) {
     Particle* fire_particle = SpawnParticle(particle_library::fire);
     fire_particle->position = fire_spout.position();
     fire_particle->position.y += 0.5_f;
-    fire_particle->velocity = particle_library::FireSpread();
-    fire_particle->velocity.y += 0.5_f;
-    fire_particle->acceleration = Vec3{0_f,0.005_f,0_f};
+    Vec3 velocity = particle_library::FireSpread();
+    velocity.y += 0.5_f;
+    fire_particle->velocity = CompactVec3::Narrow(velocity);
+    fire_particle->acceleration = CompactVec3::Narrow(Vec3{0_f,0.005_f,0_f});
   }
 }
 
@@ -92,13 +86,12 @@ void KillSelf(FireSpoutState& fire_spout) {
     Particle* smoke = SpawnParticle(particle_library::smoke);
     smoke->position = fire_spout.position();
     smoke->position.y += 0.5_f;
-    smoke->velocity = particle_library::RandomSpread() * 0.3_f;
-    smoke->velocity.y = 0_f;
+    Vec3 velocity = particle_library::RandomSpread() * 0.3_f;
+    velocity.y = 0_f;
+    smoke->velocity = CompactVec3::Narrow(velocity);
   }
 
-  // Clear out all of our collision data, so the pikmin stop attacking us
-  fire_spout.world().FreeBody(fire_spout.detection);
-  fire_spout.detection = nullptr;
+  // Clear out our health link, so the pikmin stop attacking us
   fire_spout.body->owner = Handle();
 }
 
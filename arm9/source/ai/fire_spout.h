@@ -8,7 +8,6 @@ namespace fire_spout_ai {
 
 struct FireSpoutState : PikminGameState {
   physics::Body* flame_sensor;
-  physics::Body* detection;
   int flame_timer{0};
   health_ai::HealthState* health_state;
 };
@@ -3,6 +3,7 @@
 #include "ai/pikmin.h"
 #include "dsgx.h"
 #include "pikmin_game.h"
+#include "vector_utils.h"
 
 using numeric_types::literals::operator"" _f;
 using numeric_types::literals::operator"" _brad;
@@ -58,7 +59,7 @@ void HandleWithdrawingPikmin(OnionState& onion) {
       };
 
       pikmin->set_position(onion.position() +
-          onion_sides[rand() % 3]);
+          onion_sides[onion.random.Range(3)]);
 
       if (onion.pikmin_type == PikminType::kRedPikmin) {
         onion.game->CurrentSaveData()->red_pikmin--;
@@ -126,19 +127,13 @@ void EjectSeeds(OnionState& onion) {
       pikmin->starting_state = pikmin_ai::PikminNode::kSeed;
       // pick a random direction for it to float down
       auto direction = Vec2{
-        fixed::FromRaw((rand() & ((1 << 13) - 1)) - (1 << 12)),
-        fixed::FromRaw((rand() & ((1 << 13) - 1)) - (1 << 12))
+        fixed::FromRaw((onion.random.Next() & ((1 << 13) - 1)) - (1 << 12)),
+        fixed::FromRaw((onion.random.Next() & ((1 << 13) - 1)) - (1 << 12))
       };
       direction = direction.Normalize();
       pikmin->set_velocity({direction.x * 0.12_f, 0.75_f, direction.y * 0.12_f});
       // Set the Y rotation for the seed appropriately, based on its new direction
-      Brads y_rotation = 0_brad;
-      if (direction.y <= 0_f) {
-        y_rotation = Brads::Raw(acosLerp(direction.x.data_));
-      } else {
-        y_rotation = Brads::Raw(-acosLerp(direction.x.data_));
-      }
-      pikmin->entity->set_rotation({0_brad, y_rotation, 0_brad});
+      pikmin->entity->set_rotation({0_brad, AngleFromVec2(direction), 0_brad});
     }
   }
 
@@ -13,12 +13,6 @@ namespace posy_ai {
 
 void InitAlways(PosyState& posy) {
   posy.entity->set_actor(posy.game->ActorAllocator()->Retrieve("pellet_posy"));
-  posy.detection = posy.world().AllocateBody(posy.handle);
-  posy.detection->position = posy.position();
-  posy.detection->radius = 10_f;
-  posy.detection->height = 5_f;
-  posy.detection->is_sensor = true;
-  posy.detection->collision_group = DETECT_GROUP;
 
   posy.body->collision_group = ATTACK_GROUP;
 
@@ -47,7 +41,6 @@ void StoreCurrentHealth(PosyState& posy) {
 }
 
 void GoodbyeCruelWorld(PosyState& posy) {
-  posy.world().FreeBody(posy.detection);
   posy.dead = true;
 
   // Spawn in the pellet
@@ -57,7 +50,6 @@ void GoodbyeCruelWorld(PosyState& posy) {
 
 void MarkAsDead(PosyState& posy) {
   posy.body->owner = Handle();
-  posy.detection->owner = Handle();
 }
 
 namespace PosyNode {
@@ -10,7 +10,6 @@ namespace posy_ai {
 struct PosyState : PikminGameState {
   health_ai::HealthState* health_state;
   unsigned int old_health;
-  physics::Body* detection;
 };
 
 extern StateMachine<PosyState> machine;
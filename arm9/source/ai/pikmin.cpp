@@ -12,6 +12,7 @@
 #include "particle_library.h"
 #include "particle.h"
 #include "particle_library.h"
+#include "vector_kernels.h"
 #include "vector_utils.h"
 
 using numeric_types::literals::operator"" _f;
@@ -29,6 +30,8 @@ namespace pikmin_ai {
 
 const fixed kRunSpeed = 40.0_f / 60_f;
 const fixed kTargetThreshold = 2.0_f;
+const fixed kDetectionRadius = 10_f;
+const int kMaxDetectionResults = 8;
 
 void SetPikminModel(PikminState& pikmin) {
   string color = "";
@@ -56,6 +59,16 @@ void SetPikminModel(PikminState& pikmin) {
   pikmin.entity->set_mesh(mesh.c_str());
 }
 
+// One of each color SetPikminModel picks from; seeds and sprouts are never
+// seen in large enough crowds to need them
+const render::ImpostorSource kImpostorSources[] = {
+  {"pikmin", "red_pikmin"},
+  {"pikmin", "yellow_pikmin"},
+  {"pikmin", "blue_pikmin"},
+};
+const int kImpostorSourceCount =
+    sizeof(kImpostorSources) / sizeof(kImpostorSources[0]);
+
 void InitAlways(PikminState& pikmin) {
   pikmin.body->height = 6_f;
   pikmin.body->radius = 1.0_f;
@@ -63,7 +76,8 @@ void InitAlways(PikminState& pikmin) {
   pikmin.body->collides_with_bodies = 1;
   pikmin.body->is_pikmin = 1;
   pikmin.body->is_movable = 1;
-  pikmin.body->sensor_groups = WHISTLE_GROUP | DETECT_GROUP | ATTACK_GROUP | TREASURE_GROUP;
+  pikmin.body->collision_group = PIKMIN_GROUP;
+  pikmin.body->sensor_groups = WHISTLE_GROUP | ATTACK_GROUP | TREASURE_GROUP;
 
   pikmin.entity->important = false;
 
@@ -113,6 +127,11 @@ bool LeftParent(const PikminState& pikmin) {
   return pikmin.parent == nullptr;
 }
 
+void PikminState::set_velocity(Vec3 velocity) {
+  steering_moves = false;
+  PikminGameState::set_velocity(velocity);
+}
+
 void StopMoving(PikminState& pikmin) {
   pikmin.set_velocity(Vec3{0_f, 0_f, 0_f});
 }
@@ -126,21 +145,55 @@ bool Landed(const PikminState& pikmin) {
   return pikmin.body->touching_ground;
 }
 
-void FaceTarget(PikminState& pikmin) {
+void FaceTarget(PikminState& pikmin, bool move = true) {
+  // The random roll happens now, so it stays in step with everything else
+  // this pikmin draws; the rest waits for SteerPikmin.
   Vec2 posXZ{pikmin.body->position.x, pikmin.body->position.z};
   Vec2 random_offset = Vec2{
-    fixed::FromInt(rand() % 10) / 5_f - 0.5_f,
-    fixed::FromInt(rand() % 10) / 5_f - 0.5_f,
+    fixed::FromInt(pikmin.random.Range(10)) / 5_f - 0.5_f,
+    fixed::FromInt(pikmin.random.Range(10)) / 5_f - 0.5_f,
   };
-  Vec2 new_direction = (pikmin.target + random_offset - posXZ).Normalize();
-  fixed movement_speed = ((pikmin.target + random_offset - posXZ).Length() / 4_f);
-  if (movement_speed > kRunSpeed) {
-    movement_speed = kRunSpeed;
+  pikmin.steering = true;
+  pikmin.steering_moves = move;
+  pikmin.steering_toward = pikmin.target + random_offset - posXZ;
+}
+
+void SteerPikmin(PikminState* pikmin, int count) {
+  const int kBatch = 32;
+  PikminState* steered[kBatch];
+  Vec2 toward[kBatch];
+  fixed lengths[kBatch];
+  Vec2 directions[kBatch];
+  int p = 0;
+  while (p < count) {
+    int batch = 0;
+    for (; p < count and batch < kBatch; p++) {
+      if (pikmin[p].steering and pikmin[p].active) {
+        steered[batch] = &pikmin[p];
+        toward[batch] = pikmin[p].steering_toward;
+        batch++;
+      }
+      pikmin[p].steering = false;
+    }
+    vector_kernels::LengthAndDirection(toward, batch, lengths, directions);
+    for (int i = 0; i < batch; i++) {
+      PikminState& steer = *steered[i];
+      if (steer.steering_moves) {
+        // A quarter of the remaining distance per step; lengths are never
+        // negative, so that's a shift
+        fixed movement_speed = fixed::FromRaw(lengths[i].data_ >> 2);
+        if (movement_speed > kRunSpeed) {
+          movement_speed = kRunSpeed;
+        }
+        Vec2 new_velocity = directions[i] * movement_speed;
+        Vec3 velocity = steer.velocity();
+        velocity.x = new_velocity.x;
+        velocity.z = new_velocity.y;
+        steer.set_velocity(velocity);
+      }
+      steer.entity->set_rotation(0_brad, AngleFromVec2(toward[i]), 0_brad);
+    }
   }
-  Vec2 new_velocity = new_direction * movement_speed;
-  pikmin.body->velocity.x = new_velocity.x;
-  pikmin.body->velocity.z = new_velocity.y;
-  pikmin.entity->set_rotation(0_brad, AngleFromNormalizedVec2(new_direction), 0_brad);
 }
 
 void RunToTarget(PikminState& pikmin) {
@@ -156,13 +209,13 @@ bool PikminTurn(const PikminState& pikmin) {
 
 template <int Chance>
 bool RandomTurnChance(const PikminState& pikmin) {
-  return PikminTurn(pikmin) and rand() % 100 < Chance;
+  return PikminTurn(pikmin) and pikmin.random.Range(100) < Chance;
 }
 
 void ChooseRandomTarget(PikminState& pikmin) {
   Vec2 new_target{pikmin.position().x, pikmin.position().z};
-  new_target.x += fixed::FromInt((rand() % 30) - 15);
-  new_target.y += fixed::FromInt((rand() % 30) - 15);
+  new_target.x += fixed::FromInt(pikmin.random.Range(30) - 15);
+  new_target.y += fixed::FromInt(pikmin.random.Range(30) - 15);
   pikmin.target = new_target;
 }
 
@@ -192,9 +245,15 @@ bool TooFarFromTarget(const PikminState& pikmin) {
       kTargetThreshold * kTargetThreshold;
 }
 
+bool WhistledThisFrame(const PikminState& pikmin) {
+  return pikmin.whistled_frame == pikmin.game->CurrentFrame();
+}
+
 bool CollidedWithWhistle(const PikminState& pikmin) {
   if (pikmin.current_squad == nullptr) {
-    if (pikmin.body->result_groups & WHISTLE_GROUP) {
+    // Either we heard the whistle, or bumped into the captain
+    if (WhistledThisFrame(pikmin) or
+        pikmin.body->result_groups & WHISTLE_GROUP) {
       return true;
     }
   }
@@ -202,21 +261,53 @@ bool CollidedWithWhistle(const PikminState& pikmin) {
 }
 
 void JoinSquad(PikminState& pikmin) {
-  auto result = pikmin.body->FirstCollisionWith(WHISTLE_GROUP);
-  // make sure we got a real result (this can fail in extreme cases)
-  if (result.body) {
+  Handle captain_handle = pikmin.whistled_by;
+  if (!WhistledThisFrame(pikmin)) {
+    auto result = pikmin.body->FirstCollisionWith(WHISTLE_GROUP);
+    // make sure we got a real result (this can fail in extreme cases)
+    if (!result.body) {
+      return;
+    }
+    captain_handle = result.body->owner;
+  }
 
-    auto captain = pikmin.game->RetrieveCaptain(result.body->owner);
-    if (captain) {
-      pikmin.current_squad = &captain->squad;
-      captain->squad.AddPikmin(&pikmin);
+  auto captain = pikmin.game->RetrieveCaptain(captain_handle);
+  if (captain) {
+    pikmin.current_squad = &captain->squad;
+    captain->squad.AddPikmin(&pikmin);
+  }
+}
+
+// Enemies that still have health to lose, and treasure with room for one more
+// carrier, are worth running over to.
+bool WorthChasing(const PikminState& pikmin, Body* body) {
+  if (body->collision_group & ATTACK_GROUP) {
+    return pikmin.game->RetrieveHealth(body->owner) != nullptr;
+  }
+  if (body->collision_group & TREASURE_GROUP) {
+    auto treasure = pikmin.game->RetrieveTreasure(body->owner);
+    return treasure and treasure->carryable and treasure->RoomForMorePikmin();
+  }
+  return false;
+}
+
+Body* FindChaseTarget(const PikminState& pikmin) {
+  Body* nearby[kMaxDetectionResults];
+  int count = pikmin.world().QueryCylinder(pikmin.position(),
+      kDetectionRadius, pikmin.body->height, ATTACK_GROUP | TREASURE_GROUP,
+      nearby, kMaxDetectionResults);
+  for (int i = 0; i < count; i++) {
+    if (WorthChasing(pikmin, nearby[i])) {
+      return nearby[i];
     }
   }
+  return nullptr;
 }
 
 bool ChaseTargetInvalid(const PikminState& pikmin) {
   // Some unspeakable horror caused our target to vanish or otherwise change
-  if (pikmin.world().RetrieveBody(pikmin.chase_target_body) == nullptr) {
+  Body* chase_target = pikmin.world().RetrieveBody(pikmin.chase_target_body);
+  if (chase_target == nullptr or !WorthChasing(pikmin, chase_target)) {
     return true;
   }
   return false;
@@ -262,24 +353,21 @@ bool CollideWithTarget(const PikminState& pikmin) {
   if (pikmin.current_squad) {
     return false;
   }
-  if (pikmin.body->result_groups & DETECT_GROUP) {
-    auto target_circle = pikmin.body->FirstCollisionWith(DETECT_GROUP);
-    if (target_circle.body) {
-      return true;
-    }
+  // Looking around is a query against the world, so don't do it every frame
+  if (((pikmin.handle.id + pikmin.game->CurrentFrame()) & 0x3) != 0) {
+    return false;
   }
-  return false;
+  return FindChaseTarget(pikmin) != nullptr;
 }
 
 void StoreTargetBody(PikminState& pikmin) {
-  auto target_circle = pikmin.body->FirstCollisionWith(DETECT_GROUP);
-  if (target_circle.body) {
-    pikmin.chase_target_body = target_circle.body->handle;
+  if (Body* target = FindChaseTarget(pikmin)) {
+    pikmin.chase_target_body = target->handle;
   }
 }
 
 void Aim(PikminState& pikmin) {
-  FaceTarget(pikmin);
+  FaceTarget(pikmin, false);
   pikmin.set_velocity(Vec3{0_f,0_f,0_f});
 }
 
@@ -433,13 +521,15 @@ void CreateDirtCloud(PikminState& pikmin) {
   for (int i = 0; i < 2; i++) {
     Particle* rock_particle = SpawnParticle(particle_library::rock);
     rock_particle->position = pikmin.position();
-    rock_particle->velocity += particle_library::RockSpread();
+    rock_particle->velocity = CompactVec3::Narrow(
+        rock_particle->velocity.Widen() + particle_library::RockSpread());
   }
   for (int j = 0; j < 6; j++) {
     Particle* dirt_cloud = SpawnParticle(particle_library::dirt_cloud);
     dirt_cloud->position = pikmin.position();
     dirt_cloud->position.y += 0.75_f;
-    dirt_cloud->velocity += particle_library::DirtCloudSpread();
+    dirt_cloud->velocity = CompactVec3::Narrow(
+        dirt_cloud->velocity.Widen() + particle_library::DirtCloudSpread());
   }
 }
 
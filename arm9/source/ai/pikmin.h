@@ -2,6 +2,7 @@
 #define AI_PIKMIN_H
 
 #include "ai/pikmin_game_state.h"
+#include "render/impostors.h"
 
 namespace squad_ai {
 struct SquadState;
@@ -55,14 +56,35 @@ struct PikminState : PikminGameState {
 
   Handle attack_target_body;
 
+  // Set by a captain's whistle; only counts on the frame it was blown
+  Handle whistled_by;
+  unsigned int whistled_frame{0xFFFFFFFF};
+
   //cache values for not updating so often
   numeric_types::Brads target_facing_angle;
 
+  // Left by FaceTarget for SteerPikmin, which turns (and, if moving, sets
+  // off) every pikmin that asked this frame in one pass
+  bool steering{false};
+  bool steering_moves{false};
+  Vec2 steering_toward;
+
+  // Whatever sets the velocity last in a frame wins, even over a FaceTarget
+  // still waiting on SteerPikmin
+  void set_velocity(Vec3 velocity);
+
   int starting_state{PikminNode::kIdle};
 };
 
 extern StateMachine<PikminState> machine;
 
+// Call once all the pikmin have run their logic for the frame
+void SteerPikmin(PikminState* pikmin, int count);
+
+// The meshes crowds of pikmin are made of, for render::BuildImpostors
+extern const render::ImpostorSource kImpostorSources[];
+extern const int kImpostorSourceCount;
+
 }  // namespace pikmin_ai
 
 #endif
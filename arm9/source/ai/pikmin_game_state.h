@@ -2,6 +2,7 @@
 #define AI_PIKMIN_GAME_STATE_H
 
 #include "handle.h"
+#include "random.h"
 #include "state_machine.h"
 #include "vector.h"
 
@@ -20,6 +21,10 @@ struct PikminGameState : ObjectState {
   PikminGame* game = nullptr;
   physics::Body* body;
 
+  // Seeded on spawn. Mutable so that guards, which only get a const state,
+  // can still roll the dice.
+  mutable Random random;
+
   Vec3 position() const;
   void set_position(Vec3 position);
   Vec3 velocity() const;
@@ -6,6 +6,7 @@
 #include "drawable.h"
 #include "pikmin.h"
 #include "trig.h"
+#include "vector_kernels.h"
 
 using numeric_types::literals::operator"" _f;
 using numeric_types::literals::operator"" _brad;
@@ -110,11 +111,11 @@ const fixed kSquadSpacing = 2.0_f;
 
 void UpdateTestSquare(SquadState& squad) {
   // move ourselves close to the captain
-  auto distance = (squad.captain->position() - squad.position).Length();
+  Vec3 direction;
+  auto distance = vector_kernels::LengthAndDirection(
+      squad.captain->position() - squad.position, &direction);
   if (distance > kMaxDistanceFromCaptain) {
-    auto direction = squad.captain->position() - squad.position;
-    direction = direction.Normalize() * kMaxDistanceFromCaptain;
-    squad.position = squad.captain->position() - direction;
+    squad.position = squad.captain->position() - direction * kMaxDistanceFromCaptain;
   }
 
   // easy pie! update all the pikmin targets in this squad
@@ -139,11 +140,11 @@ void UpdateTriangleShape(SquadState& squad) {
   }
 
   // move ourselves close to the captain
-  auto distance = (squad.captain->position() - squad.position).Length();
+  Vec3 direction;
+  auto distance = vector_kernels::LengthAndDirection(
+      squad.captain->position() - squad.position, &direction);
   if (distance > 3.0_f) {
-    auto direction = squad.captain->position() - squad.position;
-    direction = direction.Normalize() * 3.0_f;
-    squad.position = squad.captain->position() - direction;
+    squad.position = squad.captain->position() - direction * 3.0_f;
   }
 
   // loop through all the slots and assign a target position for each pikmin
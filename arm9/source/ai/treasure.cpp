@@ -16,25 +16,6 @@ using physics::Body;
 
 namespace treasure_ai {
 
-void TreasureState::UpdateDetectionBody() {
-  if (RoomForMorePikmin() and  !detection_active and carryable) {
-    detection = world().AllocateBody(handle);
-    detection->position = position();
-    detection->radius = 10_f;
-    detection->height = 5_f;
-    detection->is_sensor = true;
-    detection->collision_group = DETECT_GROUP;
-    detection_active = true;
-    return;
-  }
-  if (!RoomForMorePikmin() and detection_active) {
-    // Disable the detection radius so pikmin stop attempting to chase us
-    world().FreeBody(detection);
-    detection_active = false;
-    return;
-  }
-}
-
 bool TreasureState::AddPikmin(PikminState* pikmin) {
   if (RoomForMorePikmin()) {
     for (int i = 0; i < carry_slots; i++) {
@@ -42,7 +23,6 @@ bool TreasureState::AddPikmin(PikminState* pikmin) {
         active_pikmin[i] = pikmin;
         num_active_pikmin++;
         lift_timer = 0;
-        UpdateDetectionBody();
         return true;
       }
     }
@@ -56,7 +36,6 @@ void TreasureState::RemovePikmin(PikminState* pikmin) {
       active_pikmin[i] = nullptr;
       num_active_pikmin--;
       lift_timer = 0;
-      UpdateDetectionBody();
       return;
     }
   }
@@ -71,8 +50,6 @@ bool TreasureState::Moving() {
 }
 
 void Init(TreasureState& treasure) {
-  treasure.UpdateDetectionBody();
-
   treasure.body->collision_group = TREASURE_GROUP;
   treasure.body->affected_by_gravity = true;
 
@@ -119,7 +96,7 @@ void SetDestinationType(TreasureState& treasure) {
     return;
   }
   // Oh no! We can't make up our mind! Ah well, just pick one at random then.
-  treasure.destination = (DestinationType)((rand() % 3) + 1);
+  treasure.destination = (DestinationType)(treasure.random.Range(3) + 1);
 }
 
 void ClearDestinationType(TreasureState& treasure) {
@@ -151,9 +128,6 @@ void UpdatePikminPositions(TreasureState& treasure) {
 }
 
 void IdleAlways(TreasureState& treasure) {
-  if (treasure.detection_active) {
-    treasure.detection->position = treasure.position();
-  }
   UpdatePikminPositions(treasure);
   if (treasure.Moving()) {
     treasure.lift_timer++;
@@ -190,9 +164,6 @@ void MoveTowardTarget(TreasureState& treasure) {
   new_velocity.y = treasure.body->velocity.y;
   treasure.set_velocity(new_velocity);
   UpdatePikminPositions(treasure);
-  if (treasure.detection_active) {
-    treasure.detection->position = treasure.position();
-  }
 }
 
 bool DestinationReached(const TreasureState& treasure) {
@@ -205,12 +176,7 @@ void PrepareForRetrieval(TreasureState& treasure) {
   auto destination = DestinationBody(treasure);
   // Align with the destination region
   treasure.set_position(destination->position());
-  // Kill the targeting radius, so pikmin stop trying to carry us
-  if (treasure.detection_active) {
-    treasure.world().FreeBody(treasure.detection);
-    treasure.detection = nullptr;
-  }
-  // Dislodge all the pikmin carrying us
+  // Dislodge all the pikmin carrying us, and stop any more from coming over
   treasure.carryable = false;
   // Remove ourselves from physics calculations, and prepare to rise into the
   // onion
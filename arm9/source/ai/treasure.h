@@ -27,8 +27,6 @@ struct TreasureState : PikminGameState {
   pikmin_ai::PikminType pikmin_affinity{pikmin_ai::PikminType::kNone};
 
 
-  physics::Body* detection;
-  bool detection_active{false};
   pikmin_ai::PikminState* active_pikmin[100];
   int num_active_pikmin{0};
 
@@ -36,7 +34,6 @@ struct TreasureState : PikminGameState {
   void RemovePikmin(pikmin_ai::PikminState* pikmin);
   bool RoomForMorePikmin();
   bool Moving();
-  void UpdateDetectionBody();
 };
 
 extern StateMachine<TreasureState> machine;
@@ -11,6 +11,7 @@
 #include "debug/profiler.h"
 #include "debug/utilities.h"
 #include "file_utils.h"
+#include "input_utils.h"
 #include "numeric_types.h"
 #include "pikmin_game.h"
 
@@ -108,9 +109,9 @@ void UpdateDebugToggles(DebugUiState& debug_ui) {
     printf("+------------------------------+\n");
 
     // figure out if we need to toggle this frame
-    if (keysDown() & KEY_TOUCH) {
+    if (input::Down() & KEY_TOUCH) {
       touchPosition touch;
-      touchRead(&touch);
+      touch = input::Touch();
 
       if (touch.py > touch_offset and touch.py < touch_offset + 24) {
         //*toggleActive = !(*toggleActive);
@@ -134,9 +135,9 @@ void UpdateDebugSpawners(DebugUiState& debug_ui) {
   printf("|      | | %*s | |      |", 42, " ");
   printf("+------+ +-%*s-+ +------+", 42, std::string(42, '-').c_str());
 
-  if (keysDown() & KEY_TOUCH) {
+  if (input::Down() & KEY_TOUCH) {
     touchPosition touch;
-    touchRead(&touch);
+    touch = input::Touch();
 
     if (touch.px > 192) {
       debug_ui.current_spawner++;
@@ -197,19 +198,19 @@ void UpdateLevelSelect(DebugUiState& debug_ui) {
     printf((debug_ui.level_names[i] + "\n").c_str());
   }
 
-  if (keysDown() & KEY_DOWN && debug_ui.current_level < debug_ui.level_names.size() - 1) {
+  if (input::Down() & KEY_DOWN && debug_ui.current_level < debug_ui.level_names.size() - 1) {
     debug_ui.current_level++;
   }
-  if (keysDown() & KEY_UP && debug_ui.current_level > 0) {
+  if (input::Down() & KEY_UP && debug_ui.current_level > 0) {
     debug_ui.current_level--;
   }
-  if (keysDown() & KEY_A) {
+  if (input::Down() & KEY_A) {
     debug_ui.game->LoadLevel("/levels/" + debug_ui.level_names[debug_ui.current_level]);
   }
 }
 
 bool DebugSwitcherPressed(const DebugUiState&  debug_ui) {
-  return keysDown() & KEY_START;
+  return input::Down() & KEY_START;
 }
 
 namespace DebugUiNode {
@@ -0,0 +1,172 @@
+#include "debug/math_benchmark.h"
+
+#include <string>
+
+#include <nds.h>
+
+#include "debug/messages.h"
+#include "math_unit.h"
+#include "random.h"
+#include "vector.h"
+#include "vector_kernels.h"
+#include "vector_utils.h"
+
+namespace debug {
+
+namespace {
+
+const int kSamples = 256;
+
+s32 g_numerators[kSamples];
+s32 g_denominators[kSamples];
+s32 g_expected[kSamples];
+s32 g_results[kSamples];
+Vec3 g_vectors[kSamples];
+
+// Kept out of line so the compiler can't turn it into anything smarter than
+// the s64 divide Fixed used to do
+__attribute__((noinline)) s32 SoftwareDivide(s64 numerator, s32 denominator) {
+  return numerator / denominator;
+}
+
+void Report(const std::string& name, u32 ticks, int mismatches) {
+  std::string line = name + ": " + std::to_string(ticks / kSamples) + "." +
+      std::to_string((ticks % kSamples) * 10 / kSamples) + " per op";
+  if (mismatches) {
+    line += ", " + std::to_string(mismatches) + " WRONG";
+  }
+  Log(line);
+}
+
+int Mismatches() {
+  int mismatches = 0;
+  for (int i = 0; i < kSamples; i++) {
+    mismatches += g_results[i] != g_expected[i];
+  }
+  return mismatches;
+}
+
+}  // namespace
+
+void BenchmarkMath() {
+  Random random;
+  for (int i = 0; i < kSamples; i++) {
+    // Magnitudes like the ones physics sees: up to a few hundred units,
+    // with nothing near zero on the bottom
+    g_numerators[i] = (s32)(random.Next() % (512 << 12)) - (256 << 12);
+    g_denominators[i] = (s32)(random.Next() % (64 << 12)) + (1 << 10);
+    g_vectors[i] = Vec3{
+      numeric_types::fixed::FromRaw((s32)(random.Next() % (64 << 12)) - (32 << 12)),
+      numeric_types::fixed::FromRaw((s32)(random.Next() % (8 << 12)) - (4 << 12)),
+      numeric_types::fixed::FromRaw((s32)(random.Next() % (64 << 12)) - (32 << 12)),
+    };
+  }
+  volatile s32 sink = 0;
+
+  u32 start = cpuGetTiming();
+  for (int i = 0; i < kSamples; i++) {
+    g_expected[i] = SoftwareDivide((s64)g_numerators[i] << 12, g_denominators[i]);
+  }
+  Report("Divide, software", cpuGetTiming() - start, 0);
+
+  start = cpuGetTiming();
+  for (int i = 0; i < kSamples; i++) {
+    g_results[i] = divf32(g_numerators[i], g_denominators[i]);
+  }
+  Report("Divide, divf32", cpuGetTiming() - start, Mismatches());
+
+  start = cpuGetTiming();
+  for (int i = 0; i < kSamples; i++) {
+    g_results[i] = math_unit::DivideFixed(g_numerators[i], g_denominators[i]);
+  }
+  Report("Divide, math_unit", cpuGetTiming() - start, Mismatches());
+
+  start = cpuGetTiming();
+  math_unit::DivideFixed(g_numerators, g_denominators, g_results, kSamples);
+  Report("Divide, batched", cpuGetTiming() - start, Mismatches());
+
+  for (int i = 0; i < kSamples; i++) {
+    g_expected[i] = SoftwareDivide((s64)g_numerators[i] << 12, g_denominators[0]);
+  }
+  start = cpuGetTiming();
+  math_unit::DivideFixed(g_numerators, g_denominators[0], g_results, kSamples);
+  Report("Divide, batched by one", cpuGetTiming() - start, Mismatches());
+
+  for (int i = 0; i < kSamples; i++) {
+    g_expected[i] = sqrtf32(g_denominators[i]);
+  }
+  start = cpuGetTiming();
+  for (int i = 0; i < kSamples; i++) {
+    g_results[i] = sqrtf32(g_denominators[i]);
+  }
+  Report("Sqrt, sqrtf32", cpuGetTiming() - start, 0);
+
+  start = cpuGetTiming();
+  for (int i = 0; i < kSamples; i++) {
+    g_results[i] = math_unit::SqrtFixed(g_denominators[i]);
+  }
+  Report("Sqrt, math_unit", cpuGetTiming() - start, Mismatches());
+
+  // Normalize the way it used to be done, one blocking call at a time
+  for (int i = 0; i < kSamples; i++) {
+    s32 length = sqrtf32(g_vectors[i].Length2().data_);
+    g_expected[i] = length ? divf32(g_vectors[i].x.data_, length) : 0;
+  }
+  start = cpuGetTiming();
+  for (int i = 0; i < kSamples; i++) {
+    s32 length = sqrtf32(g_vectors[i].Length2().data_);
+    if (length) {
+      sink = divf32(g_vectors[i].x.data_, length);
+      sink = divf32(g_vectors[i].y.data_, length);
+      sink = divf32(g_vectors[i].z.data_, length);
+    }
+  }
+  Report("Normalize, libnds", cpuGetTiming() - start, 0);
+
+  start = cpuGetTiming();
+  for (int i = 0; i < kSamples; i++) {
+    g_results[i] = g_vectors[i].Normalize().x.data_;
+  }
+  Report("Normalize, overlapped", cpuGetTiming() - start, Mismatches());
+
+  // The kernels accumulate the squared length before shifting, so they can
+  // round differently from Normalize in the last bit; these are reference
+  // answers done the same way.
+  for (int i = 0; i < kSamples; i++) {
+    const Vec3& v = g_vectors[i];
+    s64 length2 = (s64)v.x.data_ * v.x.data_ + (s64)v.y.data_ * v.y.data_ +
+        (s64)v.z.data_ * v.z.data_;
+    s32 length = sqrt64(length2);
+    g_expected[i] = length ? SoftwareDivide((s64)v.x.data_ << 12, length) : 0;
+  }
+  static Vec3 directions[kSamples];
+  start = cpuGetTiming();
+  vector_kernels::LengthAndDirection(g_vectors, kSamples, nullptr, directions);
+  u32 ticks = cpuGetTiming() - start;
+  for (int i = 0; i < kSamples; i++) {
+    g_results[i] = directions[i].x.data_;
+  }
+  Report("Normalize, batched", ticks, Mismatches());
+
+  // Facing angles on the XZ plane, the way they used to be worked out and
+  // with Atan2. The two round differently, so there's nothing to compare.
+  start = cpuGetTiming();
+  for (int i = 0; i < kSamples; i++) {
+    Vec2 direction = Vec2{g_vectors[i].x, g_vectors[i].z}.Normalize();
+    if (direction.y.data_ <= 0) {
+      sink = acosLerp(direction.x.data_);
+    } else {
+      sink = -acosLerp(direction.x.data_);
+    }
+  }
+  Report("Angle, normalize and acosLerp", cpuGetTiming() - start, 0);
+
+  start = cpuGetTiming();
+  for (int i = 0; i < kSamples; i++) {
+    sink = AngleFromVec2(Vec2{g_vectors[i].x, g_vectors[i].z}).data_;
+  }
+  Report("Angle, Atan2", cpuGetTiming() - start, 0);
+  (void)sink;
+}
+
+}  // namespace debug
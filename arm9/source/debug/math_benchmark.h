@@ -0,0 +1,14 @@
+#ifndef DEBUG_MATH_BENCHMARK_H
+#define DEBUG_MATH_BENCHMARK_H
+
+namespace debug {
+
+// Times software division against math_unit's synchronous, batched and
+// overlapped paths, plus square roots and normalizes (including the batched
+// vector kernels), over the same random inputs. Results (and any mismatches against the software answers) go to
+// the log. Timings are in cpuGetTiming ticks.
+void BenchmarkMath();
+
+}  // namespace debug
+
+#endif  // DEBUG_MATH_BENCHMARK_H
@@ -0,0 +1,134 @@
+#include "debug/replay.h"
+
+#include "debug/messages.h"
+#include "input_utils.h"
+
+using std::string;
+
+namespace debug {
+
+namespace {
+
+// "PREC", little endian
+const u32 kMagic = 0x43455250;
+
+}  // namespace
+
+bool Replay::StartRecording(const string& filename, u32 seed,
+    const string& level) {
+  Stop();
+  file_ = fopen(filename.c_str(), "wb");
+  if (!file_) {
+    Log("Couldn't open " + filename + " for recording");
+    return false;
+  }
+  u32 header[3] = {kMagic, seed, (u32)level.size()};
+  fwrite(header, sizeof(u32), 3, file_);
+  fwrite(level.c_str(), 1, level.size(), file_);
+
+  mode_ = kRecording;
+  seed_ = seed;
+  level_ = level;
+  Log("Recording to " + filename);
+  return true;
+}
+
+bool Replay::StartReplay(const string& filename, const string& checksum_filename) {
+  Stop();
+  file_ = fopen(filename.c_str(), "rb");
+  if (!file_) {
+    return false;
+  }
+  u32 header[3];
+  if (fread(header, sizeof(u32), 3, file_) != 3 or header[0] != kMagic) {
+    Log("Not a recording: " + filename);
+    Stop();
+    return false;
+  }
+  seed_ = header[1];
+  level_.resize(header[2]);
+  if (fread(&level_[0], 1, header[2], file_) != header[2]) {
+    Log("Recording is truncated: " + filename);
+    Stop();
+    return false;
+  }
+
+  checksums_ = fopen(checksum_filename.c_str(), "w");
+  mode_ = kReplaying;
+  diverged_ = false;
+  Log("Replaying " + filename);
+  return true;
+}
+
+void Replay::Stop() {
+  if (file_) {
+    fclose(file_);
+    file_ = nullptr;
+  }
+  if (checksums_) {
+    fclose(checksums_);
+    checksums_ = nullptr;
+  }
+  mode_ = kOff;
+}
+
+Replay::Mode Replay::mode() const {
+  return mode_;
+}
+
+u32 Replay::seed() const {
+  return seed_;
+}
+
+const string& Replay::level() const {
+  return level_;
+}
+
+bool Replay::ReadWord(u32* word) {
+  if (fread(word, sizeof(u32), 1, file_) == 1) {
+    return true;
+  }
+  Log("Replay finished");
+  Stop();
+  return false;
+}
+
+void Replay::Input() {
+  // Buttons in the low half; the touch position (0-255, 0-191) above that
+  if (mode_ == kRecording) {
+    touchPosition touch = input::Touch();
+    u32 word = (input::Held() & 0xFFFF) | ((touch.px & 0xFF) << 16) |
+        ((touch.py & 0xFF) << 24);
+    fwrite(&word, sizeof(u32), 1, file_);
+  } else if (mode_ == kReplaying) {
+    u32 word;
+    if (ReadWord(&word)) {
+      touchPosition touch = {};
+      touch.px = (word >> 16) & 0xFF;
+      touch.py = word >> 24;
+      input::Set(word & 0xFFFF, touch);
+    }
+  }
+}
+
+void Replay::Checksum(unsigned int frame, u32 checksum, u32 ai_ticks,
+    u32 physics_ticks) {
+  if (mode_ == kRecording) {
+    fwrite(&checksum, sizeof(u32), 1, file_);
+  } else if (mode_ == kReplaying) {
+    u32 expected;
+    if (!ReadWord(&expected)) {
+      return;
+    }
+    if (checksum != expected and !diverged_) {
+      diverged_ = true;
+      Log("Replay diverged on frame " + std::to_string(frame));
+    }
+    if (checksums_) {
+      fprintf(checksums_, "%u %08lx %lu %lu\n", frame, (unsigned long)checksum,
+          (unsigned long)ai_ticks, (unsigned long)physics_ticks);
+    }
+  }
+}
+
+}  // namespace debug
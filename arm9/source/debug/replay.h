@@ -0,0 +1,57 @@
+#ifndef DEBUG_REPLAY_H
+#define DEBUG_REPLAY_H
+
+#include <cstdio>
+#include <string>
+
+#include <nds.h>
+
+namespace debug {
+
+// Records or plays back everything the simulation takes in from outside: the
+// starting seed and level, then one word per simulation half-step. AI halves
+// store the buttons and touch position, physics halves store a checksum of
+// the World so that a replay can tell exactly when it stopped matching.
+//
+// While replaying, a line of "frame checksum ai_ticks physics_ticks" is
+// written for every step, so two runs can be diffed frame by frame.
+class Replay {
+ public:
+  enum Mode {
+    kOff,
+    kRecording,
+    kReplaying,
+  };
+
+  bool StartRecording(const std::string& filename, u32 seed,
+      const std::string& level);
+  // Reads the header; seed() and level() are valid afterwards
+  bool StartReplay(const std::string& filename,
+      const std::string& checksum_filename);
+  void Stop();
+
+  Mode mode() const;
+  u32 seed() const;
+  const std::string& level() const;
+
+  // Call right after input::Scan on every AI half. When replaying, this
+  // replaces whatever was scanned with the recorded input.
+  void Input();
+  // Call after every physics half
+  void Checksum(unsigned int frame, u32 checksum, u32 ai_ticks,
+      u32 physics_ticks);
+
+ private:
+  bool ReadWord(u32* word);
+
+  Mode mode_{kOff};
+  FILE* file_{nullptr};
+  FILE* checksums_{nullptr};
+  u32 seed_{0};
+  std::string level_;
+  bool diverged_{false};
+};
+
+}  // namespace debug
+
+#endif  // DEBUG_REPLAY_H
@@ -2,7 +2,9 @@
 
 #include <cstdio>
 
-#include <nds/arm9/postest.h>
+#include "project_settings.h"
+#include "render/impostors.h"
+#include "vector_utils.h"
 
 namespace nt = numeric_types;
 
@@ -57,8 +59,16 @@ DrawState& Drawable::GetCachedState() {
   return cached_;
 }
 
-void Drawable::SetCache() {
+void Drawable::SetCache(fixed alpha) {
   cached_ = current_;
+  if (has_previous_ and alpha < 1_f) {
+    cached_.position = previous_position_ +
+        (current_.position - previous_position_) * alpha;
+    // Brads wrap, so the difference is always the short way around
+    s32 turn = (s16)(current_.rotation.y - previous_facing_).data_;
+    cached_.rotation.y = previous_facing_ +
+        Brads::Raw((turn * alpha.data_) >> 12);
+  }
 
   //return;
 
@@ -143,6 +153,12 @@ void Drawable::Draw() {
   if (cached_.actor == nullptr or cached_.current_mesh == nullptr) {
     return;
   }
+
+  if (cached_.impostor) {
+    render::DrawImpostor(*cached_.impostor, cached_.impostor_cell,
+        BoundingCenter(), BoundingRadius());
+    return;
+  }
   ApplyTransformation();
 
   // Apply animation.
@@ -156,6 +172,10 @@ void Drawable::Draw() {
 }
 
 void Drawable::Update() {
+  previous_position_ = current_.position;
+  previous_facing_ = current_.rotation.y;
+  has_previous_ = true;
+
   // Update the animation if one is playing.
   if (current_.animation) {
     current_.animation_frame++;
@@ -186,20 +206,47 @@ bool Drawable::InsideViewFrustrum() {
   return result;
 }
 
-numeric_types::fixed Drawable::GetRealModelZ() {
-  // Avoid clobbering the render state for this poll by pushing the current
-  // matrix before performing the position test.
-  glPushMatrix();
-  ApplyTransformation();
+Vec3 Drawable::BoundingCenter() {
+  if (cached_.rotation.x.data_ or cached_.rotation.z.data_) {
+    return cached_.position;
+  }
+  // Same rotation as the cached matrix, which the hardware applies to row
+  // vectors
+  Vec3 center = cached_.current_mesh->bounding_center * cached_.scale;
+  fixed sine = fixed::FromRaw(cached_matrix_[7]);
+  fixed cosine = fixed::FromRaw(cached_matrix_[1]);
+  return cached_.position + Vec3{
+      center.x * cosine + center.z * sine,
+      center.y,
+      center.z * cosine - center.x * sine};
+}
+
+fixed Drawable::BoundingRadius() {
+  fixed radius = cached_.current_mesh->bounding_radius;
+  if (cached_.rotation.x.data_ or cached_.rotation.z.data_) {
+    // Centered on the origin instead, so reach out past the real center
+    radius += cached_.current_mesh->bounding_center.Length();
+  }
+  return radius * cached_.scale;
+}
 
-  // Perform a hardware position test on the center of the model.
-  Vec3& center = cached_.current_mesh->bounding_center;
-  PosTest(center.x.data_, center.y.data_, center.z.data_);
-  numeric_types::fixed result;
-  result.data_ = PosTestZresult();
+void Drawable::ChooseDetail(fixed depth, int bias) {
+  depth *= fixed::FromInt(1 << bias);
+  if (cached_.current_mesh->impostor and depth > fixed::FromInt(IMPOSTOR_DEPTH)) {
+    cached_.impostor = cached_.current_mesh->impostor;
+    cached_.impostor_cell = render::ImpostorCell(*cached_.impostor,
+        cached_.rotation.y);
+    return;
+  }
+  cached_.current_mesh = cached_.current_mesh->DetailAt(depth,
+      &cached_.animation);
+}
 
-  glPopMatrix(1);
-  return result;
+u32 Drawable::DrawCost() {
+  if (cached_.impostor) {
+    return 1;
+  }
+  return cached_.current_mesh->draw_cost;
 }
 
 void Drawable::SetAnimation(std::string name) {
@@ -232,14 +279,7 @@ void Drawable::RotateToFace(Brads target_angle, Brads rate) {
 Brads Drawable::AngleTo(const Drawable* destination) {
   auto difference = Vec2{destination->position().x, destination->position().z} -
       Vec2{position().x, position().z};
-  if (difference.Length2() > 0_f) {
-    difference = difference.Normalize();
-    if (difference.y <= 0_f) {
-      return Brads::Raw(acosLerp(difference.x.data_));
-    }
-    return Brads::Raw(-acosLerp(difference.x.data_));
-  }
-  return 0_brad;
+  return AngleFromVec2(difference);
 }
 
 void Drawable::RotateToFace(const Drawable* destination, Brads rate) {
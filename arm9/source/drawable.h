@@ -4,6 +4,7 @@
 #include <string>
 
 #include "dsgx.h"
+#include "tcm.h"
 #include "vector.h"
 
 struct Rotation {
@@ -22,6 +23,11 @@ struct DrawState {
   Mesh* current_mesh;
   Animation* animation{0};
   u32 animation_frame{0};
+
+  // When set, a quad showing this cell of the impostor atlas is drawn instead
+  // of the mesh
+  render::Impostor* impostor{nullptr};
+  int impostor_cell{0};
 };
 
 // Root for anything that the various Graphics Engines may use;
@@ -31,7 +37,10 @@ class Drawable {
  public:
   Drawable();
   DrawState& GetCachedState();
-  void SetCache();
+  // Snapshots the current state for drawing. Position and facing are blended
+  // from the previous simulation step by alpha (0 to 1), so motion stays
+  // smooth however the simulation and display rates line up.
+  void SetCache(numeric_types::fixed alpha = numeric_types::fixed::FromInt(1));
 
   Vec3 position() const;
   void set_position(Vec3);
@@ -47,30 +56,49 @@ class Drawable {
   void RotateToFace(numeric_types::Brads target_angle, numeric_types::Brads rate = numeric_types::Brads::Raw(degreesToAngle(180)));
   void RotateToFace(const Drawable* destination, numeric_types::Brads rate = numeric_types::Brads::Raw(degreesToAngle(180)));
 
+  // Hardware test of the cached state against the view, which has to be set
+  // up first
   bool InsideViewFrustrum();
+  // The bounding sphere of the cached state, in world space. Rotation about X
+  // or Z is left out of the center; the radius grows to cover it instead.
+  Vec3 BoundingCenter();
+  numeric_types::fixed BoundingRadius();
+  // Swaps the cached mesh for a lower detail one, or an impostor, to suit the
+  // distance to the camera. Each step of bias halves the distances where the
+  // levels change.
+  void ChooseDetail(numeric_types::fixed depth, int bias = 0);
+  // Polygons drawn for the cached state
+  u32 DrawCost();
 
   void set_actor(Dsgx* actor);
   Dsgx* actor();
   void set_mesh(const char* mesh_name);
   Mesh* mesh();
 
+  // Called once per simulation step, before anything moves
   void Update();
-  inline void ApplyTransformation();
+  HOT_CODE void ApplyTransformation();
   void Draw();
 
-  numeric_types::fixed GetRealModelZ();
-
   void SetAnimation(std::string name);
   u32 CurrentFrame();
 
   bool important{true};
   unsigned int overlaps{0};
   bool visible{false};
+  // Handed out by the renderer when the entity is added, and never changes,
+  // for anything that has to pick the same entities every frame
+  unsigned int render_id{0};
 
  private:
   DrawState current_{};
   DrawState cached_{};
 
+  // Where we were as of the last simulation step, for interpolation
+  Vec3 previous_position_;
+  numeric_types::Brads previous_facing_;
+  bool has_previous_{false};
+
   s32 cached_matrix_[13]; //one extra entry for size; for DMA transfers
 };
 
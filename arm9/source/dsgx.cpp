@@ -1,10 +1,13 @@
 #include "dsgx.h"
 
+#include <cctype>
 #include <cstdio>
+#include <cstring>
 #include <string>
 
 #include "debug/messages.h"
 #include "debug/utilities.h"
+#include "project_settings.h"
 
 using namespace std;
 namespace nt = numeric_types;
@@ -12,6 +15,21 @@ using nt::literals::operator"" _f;
 
 constexpr u32 kChunkHeaderSizeWords{2};
 
+namespace {
+
+// Whether name ends in _lod followed by a level number, like red_pikmin_lod2
+bool IsLowerDetail(const string& name) {
+  const string kSuffix = "_lod";
+  size_t digits = name.size();
+  while (digits > 0 and isdigit((unsigned char)name[digits - 1])) {
+    digits--;
+  }
+  return digits < name.size() and digits >= kSuffix.size() and
+      name.compare(digits - kSuffix.size(), kSuffix.size(), kSuffix) == 0;
+}
+
+}  // namespace
+
 Dsgx::Dsgx(u32* data, const u32 length):
     meshes_{},
     bone_animations_{} {
@@ -23,6 +41,7 @@ Dsgx::Dsgx(u32* data, const u32 length):
 
   // Nice-ify the animation data
   CollectAnimations();
+  CollectLevelsOfDetail();
 
   // Print out a crapton of debug info
   //debug::Log("== DSGX Data ==");
@@ -105,6 +124,50 @@ void Dsgx::CollectAnimations() {
   }
 }
 
+void Dsgx::CollectLevelsOfDetail() {
+  // Lower detail versions of a mesh are exported alongside it, named
+  // <mesh>_lod1, <mesh>_lod2 and so on. Chain each one onto the level above,
+  // taking over a little further out each time; how far depends on the size
+  // of the mesh, so small things step down sooner.
+  for (auto& kv : meshes_) {
+    if (IsLowerDetail(kv.first)) {
+      continue;
+    }
+    Mesh* mesh = &kv.second;
+    auto step = mesh->bounding_radius * nt::fixed::FromInt(LOD_DISTANCE_PER_RADIUS);
+    for (int level = 1; ; level++) {
+      auto lower = meshes_.find(kv.first + "_lod" + to_string(level));
+      if (lower == meshes_.end()) {
+        break;
+      }
+      mesh->lower_detail = &lower->second;
+      mesh->lower_detail_depth = step * nt::fixed::FromInt(level);
+      for (auto& animation : mesh->animations) {
+        auto match = lower->second.animations.find(animation.first);
+        if (match != lower->second.animations.end()) {
+          animation.second.lower_detail = &match->second;
+        }
+      }
+      mesh = &lower->second;
+    }
+  }
+}
+
+Mesh* Mesh::DetailAt(Fixed<s32, 12> depth, Animation** animation) {
+  Mesh* mesh = this;
+  while (mesh->lower_detail and depth > mesh->lower_detail_depth) {
+    if (*animation) {
+      // Without the same animation, the lower level can't stand in for this one
+      if (not (*animation)->lower_detail) {
+        break;
+      }
+      *animation = (*animation)->lower_detail;
+    }
+    mesh = mesh->lower_detail;
+  }
+  return mesh;
+}
+
 void Dsgx::DsgxChunk(u32* data) {
   char* mesh_name = (char*)data;
   meshes_.emplace(mesh_name, Mesh());
@@ -8,9 +8,14 @@
 #include <nds/arm9/videoGL.h>
 #include <nds/ndstypes.h>
 
+#include "tcm.h"
 #include "vector.h"
 #include "vram_allocator.h"
 
+namespace render {
+struct Impostor;
+}
+
 struct OffsetList {
   char* name;
   u32 num_offsets;
@@ -37,6 +42,8 @@ struct Animation {
   char* name;
   u32 frame_length;
   std::vector<std::pair<AnimationReference, AnimationData>> channels;
+  // The same animation for the mesh's lower_detail, if it has one
+  Animation* lower_detail{nullptr};
 };
 
 struct BoneReference {
@@ -65,12 +72,23 @@ struct Mesh {
   Fixed<s32, 12> bounding_radius;
   u32 draw_cost{0};
 
+  // The next mesh down this one's level of detail chain, drawn instead once
+  // the mesh is further away than lower_detail_depth
+  Mesh* lower_detail{nullptr};
+  Fixed<s32, 12> lower_detail_depth;
+  // Sprites to draw instead, past IMPOSTOR_DEPTH (see render/impostors.h)
+  render::Impostor* impostor{nullptr};
+
   std::vector<BoneReference> bones;
   std::vector<TextureParam> textures;
 
   std::map<std::string, Animation> animations;
 
   void AddAnimation(char* name, u32 length, AnimationReference reference, AnimationData data);
+  // The level of detail to draw at depth, following lower_detail. If
+  // *animation is set, it's swapped for the same animation on that level, and
+  // the walk stops at the last level that has it.
+  Mesh* DetailAt(Fixed<s32, 12> depth, Animation** animation);
 };
 
 // Represents the contents of a .dsgx file.
@@ -87,7 +105,7 @@ class Dsgx {
 
   Animation* GetAnimation(std::string name, Mesh* mesh);
   BoneAnimation* GetBoneAnimation(std::string name);
-  void ApplyAnimation(Animation* animation, u32 frame, Mesh* mesh);
+  HOT_CODE void ApplyAnimation(Animation* animation, u32 frame, Mesh* mesh);
   void ApplyBoneAnimation(BoneAnimation* animation, u32 frame, Mesh* mesh);
   void ApplyTextures(VramAllocator<Texture>* texture_allocator, VramAllocator<TexturePalette>* palette_allocator);
 
@@ -102,6 +120,7 @@ private:
   void ArefChunk(u32* data);
   void AnimChunk(u32* data);
   void CollectAnimations();
+  void CollectLevelsOfDetail();
 
   std::map<std::string, Mesh> meshes_;
   std::map<std::string, BoneAnimation> bone_animations_;
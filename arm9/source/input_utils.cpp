@@ -5,34 +5,74 @@
 using numeric_types::literals::operator"" _brad;
 using numeric_types::Brads;
 
+namespace {
+
+u32 g_held = 0;
+u32 g_previous = 0;
+touchPosition g_touch;
+
+}  // namespace
+
+void input::Scan() {
+  scanKeys();
+  touchPosition touch = {};
+  u32 held = input::Held();
+  if (held & KEY_TOUCH) {
+    touchRead(&touch);
+  }
+  Set(held, touch);
+}
+
+void input::Set(u32 held, touchPosition touch) {
+  g_previous = g_held;
+  g_held = held;
+  g_touch = touch;
+}
+
+u32 input::Held() {
+  return g_held;
+}
+
+u32 input::Down() {
+  return g_held & ~g_previous;
+}
+
+u32 input::Up() {
+  return g_previous & ~g_held;
+}
+
+touchPosition input::Touch() {
+  return g_touch;
+}
+
 Brads input::DPadDirection()  {
   // Todo(Nick) This feels messy. Find a way to make this cleaner.
 
-  if (keysHeld() & KEY_RIGHT) {
-    if (keysHeld() & KEY_UP) {
+  if (input::Held() & KEY_RIGHT) {
+    if (input::Held() & KEY_UP) {
       return 45_brad;
     }
-    if (keysHeld() & KEY_DOWN) {
+    if (input::Held() & KEY_DOWN) {
       return 315_brad;
     }
     return 0_brad;
   }
 
-  if (keysHeld() & KEY_LEFT) {
-    if (keysHeld() & KEY_UP) {
+  if (input::Held() & KEY_LEFT) {
+    if (input::Held() & KEY_UP) {
       return 135_brad;
     }
-    if (keysHeld() & KEY_DOWN) {
+    if (input::Held() & KEY_DOWN) {
       return 225_brad;
     }
     return 180_brad;
   }
 
-  if (keysHeld() & KEY_UP) {
+  if (input::Held() & KEY_UP) {
     return 90_brad;
   }
 
-  if (keysHeld() & KEY_DOWN) {
+  if (input::Held() & KEY_DOWN) {
     return 270_brad;
   }
 
@@ -1,10 +1,25 @@
 #ifndef INPUT_UTILS_H
 #define INPUT_UTILS_H
 
+#include <nds/arm9/input.h>
+
 #include "numeric_types.h"
 
 namespace input {
 
+// Everything in the game reads the buttons through here rather than asking
+// libnds directly, so that a recorded session can stand in for the hardware.
+// Scan (or Set) once per simulation step; Down and Up are worked out from
+// what was held the step before.
+void Scan();
+void Set(u32 held, touchPosition touch);
+
+u32 Held();
+u32 Down();
+u32 Up();
+// Only meaningful while KEY_TOUCH is held
+touchPosition Touch();
+
 numeric_types::Brads DPadDirection();
 
 } // namespace input
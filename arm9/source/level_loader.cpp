@@ -16,8 +16,9 @@ using numeric_types::fixed;
 
 namespace level_loader {
 
-const int kHeightmapBufferSize = 1024 * 512;
-u8 heightmap_buffer[kHeightmapBufferSize];
+// Holds the tiled heightmap file as-is; physics::Heightmap reads it in place.
+// Sized to whatever the level's file packed down to, and replaced along with it.
+std::vector<char> heightmap_file;
 
 void LoadLevel(PikminGame& game, std::string filename) {
 	FILE* file = fopen(filename.c_str(), "r");
@@ -25,8 +26,25 @@ void LoadLevel(PikminGame& game, std::string filename) {
 	char arg_buffer[256];
 	Handle last_handle;
 	PikminGameState* last_object{nullptr};
+	// The world can only be resized while it's empty, so a "bodies" command
+	// has to come before anything is spawned. Levels without one get the
+	// default size.
+	bool world_sized = false;
 	while (fscanf(file, "%s", command_buffer) > 0) {
-		if (strcmp(command_buffer, "spawn") == 0) {
+		if (strcmp(command_buffer, "bodies") == 0) {
+			int capacity;
+			fscanf(file, "%d", &capacity);
+			if (world_sized) {
+				debug::Log("Body count must come before any spawns, ignoring.");
+			} else {
+				game.world().Reserve(capacity);
+				world_sized = true;
+			}
+		} else if (strcmp(command_buffer, "spawn") == 0) {
+			if (!world_sized) {
+				game.world().Reserve(PHYSICS_DEFAULT_BODIES);
+				world_sized = true;
+			}
 			fscanf(file, "%s", arg_buffer);
 			debug::Log("Spawning: " + std::string(arg_buffer));
 			last_handle = game.Spawn(arg_buffer);
@@ -53,13 +71,22 @@ void LoadLevel(PikminGame& game, std::string filename) {
 			last_object->entity->set_mesh(arg_buffer);
 		} else if (strcmp(command_buffer, "heightmap") == 0) {
 			fscanf(file, "%s", arg_buffer);
-			LoadEntireFileIntoMem("/heightmaps/" + std::string(arg_buffer) + ".height", (char*)heightmap_buffer, kHeightmapBufferSize);
-			game.world().SetHeightmap(heightmap_buffer);
-			debug::Log("Set heightmap: " + std::string(arg_buffer));
+			auto file = LoadEntireFile("/heightmaps/" + std::string(arg_buffer) + ".height");
+			if (file.empty()) {
+				// Keep the old one, which the world still points into
+				debug::Log("Couldn't load heightmap: " + std::string(arg_buffer));
+			} else {
+				game.world().SetHeightmap((const u8*)file.data());
+				heightmap_file.swap(file);
+				debug::Log("Set heightmap: " + std::string(arg_buffer));
+			}
 		} else {
 			debug::Log("Unrecognized command: " + std::string(command_buffer));
 		}
 	} 
+	if (!world_sized) {
+		game.world().Reserve(PHYSICS_DEFAULT_BODIES);
+	}
 }
 
 } // namespace level_loader
\ No newline at end of file
@@ -7,13 +7,16 @@
 #include <nds.h>
 
 #include "ai/captain.h"
+#include "ai/pikmin.h"
 #include "debug/messages.h"
 #include "debug/utilities.h"
+#include "render/impostors.h"
 #include "render/multipass_renderer.h"
 #include "file_utils.h"
 #include "level_loader.h"
 #include "particle_library.h"
 #include "pikmin_game.h"
+#include "project_settings.h"
 
 using captain_ai::CaptainState;
 
@@ -46,6 +49,11 @@ void InitSubScreen() {
   InitDebugConsole();
 }
 
+void InitClearColor() {
+  glClearColor(4, 4, 4, 31);
+  GFX_CLEAR_COLOR = GFX_CLEAR_COLOR | POLY_FOG;
+}
+
 void InitMainScreen() {
   videoSetMode(MODE_0_3D);
   glInit();
@@ -59,12 +67,10 @@ void InitMainScreen() {
     glFogDensity(i, i * 4);
   }
 
-  glClearColor(4, 4, 4, 31);
+  InitClearColor();
   glClearDepth(0x7FFF);
   glViewport(0, 0, 255, 191);
 
-  GFX_CLEAR_COLOR = GFX_CLEAR_COLOR | POLY_FOG;
-
   Vec3 light0_direction = Vec3{1_f, -1_f, -1_f}.Normalize() * 0.99_f;
   Vec3 light1_direction = Vec3{-1_f, -1_f, -1_f}.Normalize() * 0.99_f;
 
@@ -210,10 +216,16 @@ void Init(PikminGame& game) {
   LoadTextures(game);
   LoadActors(game);
   particle_library::Init(game.TextureAllocator(), game.TexturePaletteAllocator());
+  render::BuildImpostors(game.ActorAllocator(), game.TextureAllocator(),
+      pikmin_ai::kImpostorSources, pikmin_ai::kImpostorSourceCount);
+  InitClearColor();
   game.LoadLevel("/levels/collision_test.level");
 
   game.InitSound("/soundbank.bin");
 
+  // Play back a recorded session, if there is one
+  game.StartReplay(REPLAY_INPUT_FILE);
+
   glPushMatrix();
 }
 
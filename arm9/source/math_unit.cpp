@@ -0,0 +1,45 @@
+#include "math_unit.h"
+
+namespace math_unit {
+
+#ifndef ARM9
+namespace host {
+s64 g_numerator = 0;
+s32 g_denominator = 1;
+u64 g_sqrt_param = 0;
+}  // namespace host
+#endif
+
+void DivideFixed(const s32* numerators, const s32* denominators, s32* results,
+    int count) {
+  if (count <= 0) {
+    return;
+  }
+  StartDivide((s64)numerators[0] << 12, denominators[0]);
+  for (int i = 1; i < count; i++) {
+    // Load the next pair while the divider is busy with this one
+    s64 numerator = (s64)numerators[i] << 12;
+    s32 denominator = denominators[i];
+    s32 result = DivideResult();
+    StartDivide(numerator, denominator);
+    results[i - 1] = result;
+  }
+  results[count - 1] = DivideResult();
+}
+
+void DivideFixed(const s32* numerators, s32 denominator, s32* results,
+    int count) {
+  if (count <= 0) {
+    return;
+  }
+  StartDivide((s64)numerators[0] << 12, denominator);
+  for (int i = 1; i < count; i++) {
+    s64 numerator = (s64)numerators[i] << 12;
+    s32 result = DivideResult();
+    StartDivideAgain(numerator);
+    results[i - 1] = result;
+  }
+  results[count - 1] = DivideResult();
+}
+
+}  // namespace math_unit
@@ -0,0 +1,112 @@
+#ifndef MATH_UNIT_H
+#define MATH_UNIT_H
+
+#include <nds/arm9/math.h>
+#include <nds/ndstypes.h>
+
+// Front end for the ARM9's divide and square root units. Both run on their
+// own once started (a 64/32 divide takes 34 cycles, a 64 bit root 13), so
+// rather than waiting on every call like libnds' divf32 and sqrtf32 do, the
+// work can be started, something else done, and the result collected later.
+//
+// The units are shared by everything, so nothing between a Start and its
+// Result may divide or take a root itself, and that includes Fixed's
+// operator/. Interrupt handlers must leave them alone entirely.
+//
+// Off the DS, these fall back to plain integer math with the same results.
+namespace math_unit {
+
+#ifdef ARM9
+
+inline void StartDivide(s64 numerator, s32 denominator) {
+  REG_DIVCNT = DIV_64_32;
+  REG_DIV_NUMER = numerator;
+  REG_DIV_DENOM_L = denominator;
+}
+
+// Any write restarts the divider, so when only the numerator changes there's
+// no need to hand over the denominator again
+inline void StartDivideAgain(s64 numerator) {
+  REG_DIV_NUMER = numerator;
+}
+
+inline s32 DivideResult() {
+  while (REG_DIVCNT & DIV_BUSY) {
+  }
+  return REG_DIV_RESULT_L;
+}
+
+inline void StartSqrt(u64 value) {
+  REG_SQRTCNT = SQRT_64;
+  REG_SQRT_PARAM = value;
+}
+
+inline u32 SqrtResult() {
+  while (REG_SQRTCNT & SQRT_BUSY) {
+  }
+  return REG_SQRT_RESULT;
+}
+
+#else
+
+namespace host {
+extern s64 g_numerator;
+extern s32 g_denominator;
+extern u64 g_sqrt_param;
+}  // namespace host
+
+inline void StartDivide(s64 numerator, s32 denominator) {
+  host::g_numerator = numerator;
+  host::g_denominator = denominator;
+}
+
+inline void StartDivideAgain(s64 numerator) {
+  host::g_numerator = numerator;
+}
+
+inline s32 DivideResult() {
+  return div64(host::g_numerator, host::g_denominator);
+}
+
+inline void StartSqrt(u64 value) {
+  host::g_sqrt_param = value;
+}
+
+inline u32 SqrtResult() {
+  return sqrt64(host::g_sqrt_param);
+}
+
+#endif
+
+// The same, for when there's nothing else to do in the meantime
+inline s32 Divide(s64 numerator, s32 denominator) {
+  StartDivide(numerator, denominator);
+  return DivideResult();
+}
+
+inline u32 Sqrt(u64 value) {
+  StartSqrt(value);
+  return SqrtResult();
+}
+
+// 20.12 versions of the above, matching divf32 and sqrtf32
+inline s32 DivideFixed(s32 numerator, s32 denominator) {
+  return Divide((s64)numerator << 12, denominator);
+}
+
+inline s32 SqrtFixed(s32 value) {
+  return Sqrt((u64)value << 12);
+}
+
+// results[i] = numerators[i] / denominators[i], all in 20.12. Each divide is
+// started the moment the one before it finishes, and its result is stored
+// while the next one runs. results may alias numerators.
+void DivideFixed(const s32* numerators, const s32* denominators, s32* results,
+    int count);
+// As above, with a single denominator for everything
+void DivideFixed(const s32* numerators, s32 denominator, s32* results,
+    int count);
+
+}  // namespace math_unit
+
+#endif  // MATH_UNIT_H
@@ -5,6 +5,8 @@
 #include <nds/arm9/trig_lut.h>
 #include <nds/ndstypes.h>
 
+#include "math_unit.h"
+
 namespace numeric_types {
 
 // Represents a fixed point integral type.
@@ -75,10 +77,9 @@ class Fixed {
   // Multiplication and division
   Fixed<T, F> operator*(const Fixed<T, F>& other) const {Fixed<T,F> r; r.data_ = ((s64)data_ * (s64)other.data_) >> F; return r;}
   Fixed<T, F>& operator*=(const Fixed<T, F>& other) {data_ = ((s64)data_ * (s64)other.data_) >> F; return *this;}
-  //Fixed<T, F> operator/(const Fixed<T, F>& other) {Fixed<T,F> r; r.data_ = (data_ << (F / 2)) / (other.data_ >> (F / 2)); return r;}
-  //Fixed<T, F>& operator/=(const Fixed<T, F>& other) {data_ = (data_ << (F / 2)) / (other.data_ >> (F / 2)); return *this;}
-  Fixed<T, F> operator/(const Fixed<T, F>& other) const {Fixed<T,F> r; r.data_ = ((s64)data_ << F) / (other.data_); return r;}
-  Fixed<T, F>& operator/=(const Fixed<T, F>& other) {data_ = ((s64)data_ << F) / (other.data_); return *this;}
+  // Division goes through the hardware divider (see math_unit.h)
+  Fixed<T, F> operator/(const Fixed<T, F>& other) const {Fixed<T,F> r; r.data_ = math_unit::Divide((s64)data_ << F, other.data_); return r;}
+  Fixed<T, F>& operator/=(const Fixed<T, F>& other) {data_ = math_unit::Divide((s64)data_ << F, other.data_); return *this;}
 
   //unary negation
   constexpr Fixed operator-() { return Fixed{-data_}; }
@@ -96,17 +97,7 @@ class Fixed {
   // values with differing fractional parts.
   template<int V, int V2>
   struct AbsoluteDifference {
-    enum { value = AbsoluteDifference<V - 1, V2 - 1>::value };
-  };
-
-  template<int V>
-  struct AbsoluteDifference<V, 0> {
-    enum { value = V };
-  };
-
-  template<int V2>
-  struct AbsoluteDifference<0, V2> {
-    enum { value = V2 };
+    enum { value = V > V2 ? V - V2 : V2 - V };
   };
 };
 
@@ -123,13 +114,6 @@ constexpr fixed operator"" _f(long double value) {
 }
 }  // namespace literals
 
-// Hardware division overloads
-/*
-template<>
-fixed Fixed<s32, 12>::operator/(const fixed& other);// {fixed r; r.data_ = divf32(data_, other.data_); return r;}
-template<>
-fixed& Fixed<s32, 12>::operator/=(const fixed& other);// {data_ = divf32(data_, other.data_); return *this;}
-*/
 class Degrees
 {
  public:
@@ -4,6 +4,7 @@
 
 #include "numeric_types.h"
 #include "project_settings.h"
+#include "vector_utils.h"
 
 using numeric_types::literals::operator"" _f;
 using numeric_types::literals::operator"" _brad;
@@ -34,8 +35,10 @@ void UpdateParticles() {
       if (particle.age > particle.lifespan) {
         particle.active = false;
       } else {
-        particle.position += particle.velocity;
-        particle.velocity += particle.acceleration;
+        Vec3 velocity = particle.velocity.Widen();
+        particle.position += velocity;
+        particle.velocity =
+            CompactVec3::Narrow(velocity + particle.acceleration.Widen());
         particle.alpha = particle.alpha - particle.fade_rate;
         particle.scale = particle.scale + particle.scale_rate;
         particle.rotation += particle.rotation_rate;
@@ -56,35 +59,26 @@ void UpdateParticles() {
   }
 }
 
-void DrawParticles(Vec3 camera_position, Vec3 target_position) {
+void DrawParticles(Vec3 camera_position, Vec3 target_position, int budget) {
   // figure out the angle toward the camera (From the target; this will
   // end up being shared among all particles)
   Brads x_angle;
   Brads y_angle;
   auto difference_xz = Vec2{camera_position.x, camera_position.z} -
       Vec2{target_position.x, target_position.z};
-  if (difference_xz.Length2() > 0_f) {
+  auto xz_length = difference_xz.Length();
+  if (xz_length > 0_f) {
     // Rotate about the Y axis to face the camera
-    auto difference = difference_xz.Normalize();
-    if (difference.y <= 0_f) {
-      y_angle = Brads::Raw(acosLerp(difference.x.data_)) + 270_brad;
-    } else {
-      y_angle = Brads::Raw(-acosLerp(difference.x.data_)) + 270_brad;
-    }
+    y_angle = AngleFromVec2(difference_xz) + 270_brad;
 
     // Use the distance to figure out rotation about the X axis
-    auto xz_length = difference_xz.Length();
-    difference = Vec2{xz_length, -camera_position.y}.Normalize();
-    if (difference.y <= 0_f) {
-      x_angle = Brads::Raw(acosLerp(difference.x.data_));
-    } else {
-      x_angle = Brads::Raw(-acosLerp(difference.x.data_));
-    }
+    x_angle = AngleFromVec2(Vec2{xz_length, -camera_position.y});
   }
 
-  for (int slot = 0; slot < MAX_PARTICLES; slot++) {
+  for (int slot = 0; slot < MAX_PARTICLES and budget > 0; slot++) {
     Particle& particle = g_particles[slot];
     if (particle.active) {
+      budget--;
       int alpha = (int)(particle.alpha * 31_f);
       if (alpha > 31) {
         alpha = 31;
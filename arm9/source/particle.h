@@ -1,13 +1,16 @@
 #ifndef PARTICLE_H
 #define PARTICLE_H
 
+#include "tcm.h"
 #include "vector.h"
 #include "vram_allocator.h"
 
 struct Particle {
   Vec3 position;
-  Vec3 velocity;
-  Vec3 acceleration;
+  // Particles drift a fraction of a unit per frame, well inside a compact
+  // vector's range
+  CompactVec3 velocity;
+  CompactVec3 acceleration;
 
   u16 lifespan;
   u16 age;
@@ -34,9 +37,10 @@ struct Particle {
   u16 color{RGB15(31, 31, 31)};
 };
 
-void UpdateParticles();
+HOT_CODE void UpdateParticles();
 Particle* SpawnParticle(Particle& prototype);
-void DrawParticles(Vec3 camera_position, Vec3 target_position);
+// Draws at most budget particles, lowest slots first; the rest are skipped
+void DrawParticles(Vec3 camera_position, Vec3 target_position, int budget);
 int ActiveParticles();
 
 #endif
@@ -70,8 +70,8 @@ void Init(VramAllocator<Texture>* texture_allocator, VramAllocator<TexturePalett
   rock.lifespan = 16;
   rock.fade_rate = 1_f / 32_f;
   rock.scale = 0.4_f;
-  rock.velocity = Vec3{0_f,1_f,0_f};
-  rock.acceleration = Vec3{0_f,-GRAVITY_CONSTANT,0_f};
+  rock.velocity = CompactVec3::Narrow(Vec3{0_f,1_f,0_f});
+  rock.acceleration = CompactVec3::Narrow(Vec3{0_f,-GRAVITY_CONSTANT,0_f});
 }
 
 // Utility functions for setting particle properties and variance
@@ -107,8 +107,9 @@ Vec3 DirtCloudSpread() {
 
 void SpreadPikiStar(Particle* particle) {
   particle->position += RandomSpread() * 0.6_f;
-  particle->velocity += RandomSpread() * 0.06_f;
-  particle->acceleration = particle->velocity * (-1_f / 32_f);
+  Vec3 velocity = particle->velocity.Widen() + RandomSpread() * 0.06_f;
+  particle->velocity = CompactVec3::Narrow(velocity);
+  particle->acceleration = CompactVec3::Narrow(velocity * (-1_f / 32_f));
   particle->color_weight = rand() & 32;
   particle->rotation = numeric_types::Brads::Raw(degreesToAngle(rand()));
   particle->rotation_rate = numeric_types::Brads::Raw(degreesToAngle(rand() % 8 - 4));
@@ -3,9 +3,21 @@
 using physics::Body;
 
 physics::CollisionResult Body::FirstCollisionWith(u32 collision_mask) {
-  for (int i = 0; i < 8; i++) {
-    if (collision_results[i].collision_group & collision_mask) {
-      return collision_results[i];
+  for (int i = 0; i < num_results; i++) {
+    if (results[i].collision_group & collision_mask) {
+      return results[i];
+    }
+  }
+  return CollisionResult();
+}
+
+physics::CollisionResult Body::FirstContactBegunWith(u32 collision_mask) {
+  if (began_groups & collision_mask) {
+    for (int i = 0; i < num_results; i++) {
+      if (results[i].event == kContactBegin and
+          (results[i].collision_group & collision_mask)) {
+        return results[i];
+      }
     }
   }
   return CollisionResult();
@@ -1,8 +1,6 @@
 #ifndef PHYSICS_BODY_H
 #define PHYSICS_BODY_H
 
-#include <array>
-
 #include "handle.h"
 #include "numeric_types.h"
 #include "project_settings.h"
@@ -19,14 +17,20 @@ struct BodyHandle {
   bool IsValid() const;
 };
 
+enum ContactEvent : u8 {
+  kContactBegin,    // First step these two bodies touched
+  kContactPersist,  // Touching this step and the one before
+  kContactEnd,      // Touched last step, but not this one
+};
+
 struct CollisionResult {
   Body* body;
   u32 collision_group;
-};
-
-struct Neighbor {
-  BodyHandle handle;
-  numeric_types::Fixed<s32,12> distance = numeric_types::Fixed<s32,12>::FromInt(0);
+  // The other body's generation when the contact was recorded. An ended
+  // contact may point at a body that has since been freed, so check this
+  // before following it.
+  unsigned short generation;
+  ContactEvent event;
 };
 
 struct Body {
@@ -44,16 +48,8 @@ struct Body {
     numeric_types::Fixed<s32,12>::FromInt(0),
     numeric_types::Fixed<s32,12>::FromInt(0)
   };;
-  Vec3 acceleration = Vec3{
-    numeric_types::Fixed<s32,12>::FromInt(0),
-    numeric_types::Fixed<s32,12>::FromInt(0),
-    numeric_types::Fixed<s32,12>::FromInt(0)
-  };;
-
-  Vec2 xz_position = Vec2{
-    numeric_types::Fixed<s32,12>::FromInt(0),
-    numeric_types::Fixed<s32,12>::FromInt(0)
-  };;
+  // Only ever a fraction of gravity, so it's stored compactly
+  CompactVec3 acceleration = CompactVec3{};
 
   //all bodies are cylinders, so they have a radius and a height. Their base
   //starts at position.y, so their highest point is at position.y + height.
@@ -73,9 +69,16 @@ struct Body {
 
   //contains all the groups we collided with *this frame*
   u32 result_groups{0};
+  //and the groups we started and stopped touching this frame
+  u32 began_groups{0};
+  u32 ended_groups{0};
 
-  u32 num_results{0};
-  CollisionResult collision_results[8];
+  // This step's contacts, in the World's contact arena: num_results current
+  // contacts (begin or persist), followed by num_ended ended ones. Only valid
+  // until the next physics step.
+  const CollisionResult* results{nullptr};
+  u16 num_results{0};
+  u16 num_ended{0};
 
   unsigned short touching_ground : 1;
 
@@ -87,15 +90,21 @@ struct Body {
   unsigned short is_movable : 1;  // Can this body be moved during collision?
   unsigned short is_pikmin : 1;  // Pikmin are treated as a special case
   unsigned short affected_by_gravity : 1;
-  unsigned short is_very_important : 1;
+
+  // Managed by the World. Sleeping bodies stay visible to collision, but
+  // don't integrate or collide with the level until something wakes them.
+  unsigned short sleeping : 1;
+  // Bumped by another body this step while asleep; woken once the step ends
+  unsigned short woken : 1;
+  u8 idle_frames;
+  Vec3 rest_position;
 
   CollisionResult FirstCollisionWith(u32 collision_mask);
+  CollisionResult FirstContactBegunWith(u32 collision_mask);
   unsigned short active : 1;
   unsigned short generation;
+  // Where the body started this step
   Vec3 old_position;
-  numeric_types::Fixed<s32,12> old_radius;
-
-  std::array<Neighbor, MAX_PHYSICS_NEIGHBORS> neighbors;
 
   BodyHandle GetHandle();
 };
@@ -0,0 +1,153 @@
+#include "heightmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using physics::Heightmap;
+
+namespace {
+
+// "HMT1", little endian
+const u32 kMagic = 0x31544D48;
+const u16 kNoTile = 0xFFFF;
+const u16 kNoWalls = 0xFFFF;
+
+}  // namespace
+
+Heightmap::Heightmap() {
+  Clear();
+}
+
+bool Heightmap::Load(const u8* data) {
+  Clear();
+  const u32* header = (const u32*)data;
+  if (header[0] != kMagic) {
+    return false;
+  }
+  const u16* sizes = (const u16*)(data + 4);
+  width_ = sizes[0];
+  height_ = sizes[1];
+  unique_tiles_ = sizes[2];
+  tiles_x_ = (width_ + kTileSize - 1) >> kTileShift;
+  tiles_z_ = (height_ + kTileSize - 1) >> kTileShift;
+
+  tile_map_ = (const u16*)(data + 12);
+  // The map is padded out to a word boundary, so the offsets stay aligned
+  int map_bytes = (tiles_x_ * tiles_z_ * 2 + 3) & ~3;
+  tile_offsets_ = (const u32*)(data + 12 + map_bytes);
+  tile_data_ = data + 12 + map_bytes + unique_tiles_ * 4;
+  return true;
+}
+
+void Heightmap::Clear() {
+  width_ = 0;
+  height_ = 0;
+  tiles_x_ = 0;
+  tiles_z_ = 0;
+  unique_tiles_ = 0;
+  wall_tiles_.clear();
+  wall_masks_.clear();
+  for (int i = 0; i < HEIGHTMAP_CACHE_TILES; i++) {
+    cache_tag_[i] = kNoTile;
+  }
+}
+
+int Heightmap::width() const {
+  return width_;
+}
+
+int Heightmap::height() const {
+  return height_;
+}
+
+const u8* Heightmap::DecodeTile(u16 tile) {
+  // Tile IDs are handed out in scan order, so neighboring tiles land in
+  // different cache lines
+  int line = tile & (HEIGHTMAP_CACHE_TILES - 1);
+  u8* cells = cache_[line];
+  if (cache_tag_[line] == tile) {
+    return cells;
+  }
+  cache_tag_[line] = tile;
+
+  const u8* source = tile_data_ + tile_offsets_[tile];
+  const u8 base = source[0];
+  const int bits = source[1];
+  const u8* deltas = source + 2;
+  if (bits == 0) {
+    memset(cells, base, kTileCells);
+  } else if (bits == 8) {
+    for (int i = 0; i < kTileCells; i++) {
+      cells[i] = base + deltas[i];
+    }
+  } else {
+    // 1, 2 or 4 bits per cell, lowest bits first, never split across bytes
+    const int per_byte = 8 / bits;
+    const u8 mask = (1 << bits) - 1;
+    for (int i = 0; i < kTileCells; i++) {
+      u8 packed = deltas[i / per_byte] >> ((i % per_byte) * bits);
+      cells[i] = base + (packed & mask);
+    }
+  }
+  return cells;
+}
+
+u8 Heightmap::Sample(int x, int z) {
+  if (width_ == 0) {
+    return 0;
+  }
+  if (x < 0) {x = 0;}
+  if (z < 0) {z = 0;}
+  if (x >= width_) {x = width_ - 1;}
+  if (z >= height_) {z = height_ - 1;}
+
+  u16 tile = tile_map_[(z >> kTileShift) * tiles_x_ + (x >> kTileShift)];
+  const u8* cells = DecodeTile(tile);
+  return cells[((z & (kTileSize - 1)) << kTileShift) + (x & (kTileSize - 1))];
+}
+
+void Heightmap::BakeWalls(int threshold) {
+  wall_tiles_.assign(tiles_x_ * tiles_z_, kNoWalls);
+  wall_masks_.clear();
+  for (int tz = 0; tz < tiles_z_; tz++) {
+    for (int tx = 0; tx < tiles_x_; tx++) {
+      u32 masks[4] = {0, 0, 0, 0};
+      bool any_walls = false;
+      for (int cell = 0; cell < kTileCells; cell++) {
+        int x = (tx << kTileShift) + (cell & (kTileSize - 1));
+        int z = (tz << kTileShift) + (cell >> kTileShift);
+        if (x >= width_ or z >= height_) {
+          continue;
+        }
+        int here = Sample(x, z) & 0x7F;
+        u32 edges = 0;
+        if (abs((Sample(x + 1, z) & 0x7F) - here) > threshold) {
+          edges |= kWallPlusX;
+        }
+        if (abs((Sample(x, z + 1) & 0x7F) - here) > threshold) {
+          edges |= kWallPlusZ;
+        }
+        if (edges) {
+          masks[cell >> 4] |= edges << ((cell & 15) * 2);
+          any_walls = true;
+        }
+      }
+      if (any_walls and wall_masks_.size() / 4 < kNoWalls) {
+        wall_tiles_[tz * tiles_x_ + tx] = wall_masks_.size() / 4;
+        wall_masks_.insert(wall_masks_.end(), masks, masks + 4);
+      }
+    }
+  }
+}
+
+u8 Heightmap::WallEdges(int x, int z) {
+  if (x < 0 or z < 0 or x >= width_ or z >= height_) {
+    return 0;
+  }
+  u16 walls = wall_tiles_[(z >> kTileShift) * tiles_x_ + (x >> kTileShift)];
+  if (walls == kNoWalls) {
+    return 0;
+  }
+  int cell = ((z & (kTileSize - 1)) << kTileShift) + (x & (kTileSize - 1));
+  return (wall_masks_[walls * 4 + (cell >> 4)] >> ((cell & 15) * 2)) & 0x3;
+}
@@ -0,0 +1,76 @@
+#ifndef PHYSICS_HEIGHTMAP_H
+#define PHYSICS_HEIGHTMAP_H
+
+#include <vector>
+
+#include <nds/ndstypes.h>
+
+#include "project_settings.h"
+
+namespace physics {
+
+// Level collision heights, stored as square tiles of kTileSize cells. Each
+// distinct tile is stored once in a dictionary, as a base value plus deltas
+// packed to however many bits the tile needs (none at all for flat tiles.)
+// See tools/image-to-heightmap.py for the file layout.
+//
+// Tiles are decoded on demand into a small direct-mapped cache, so repeated
+// lookups in the same area cost about the same as the raw map did.
+//
+// Walls are baked once at load time into a per-tile side table: two bits per
+// cell, for the edges shared with the +X and +Z neighbors. Tiles without any
+// walls don't store anything.
+class Heightmap {
+  public:
+    static const int kTileShift = 3;
+    static const int kTileSize = 1 << kTileShift;
+    static const int kTileCells = kTileSize * kTileSize;
+
+    enum WallEdge : u8 {
+      kWallPlusX = 1 << 0,
+      kWallPlusZ = 1 << 1,
+    };
+
+    Heightmap();
+
+    // Points at the file as loaded; nothing is copied, so the data has to stay
+    // put for as long as the map is in use. Returns false (and leaves the map
+    // empty) if the data isn't a tiled heightmap.
+    bool Load(const u8* data);
+    void Clear();
+
+    // The raw cell value, with coordinates clamped to the map edges
+    u8 Sample(int x, int z);
+
+    // Marks every edge where neighboring cells differ by more than threshold
+    // (in raw height steps.) Call after Load.
+    void BakeWalls(int threshold);
+    // WallEdge bits for this cell; nothing outside the map is a wall
+    u8 WallEdges(int x, int z);
+
+    int width() const;
+    int height() const;
+
+  private:
+    const u8* DecodeTile(u16 tile);
+
+    int width_ = 0;
+    int height_ = 0;
+    int tiles_x_ = 0;
+    int tiles_z_ = 0;
+    int unique_tiles_ = 0;
+    const u16* tile_map_ = nullptr;
+    const u32* tile_offsets_ = nullptr;
+    const u8* tile_data_ = nullptr;
+
+    std::vector<u16> wall_tiles_;
+    // 64 cells * 2 bits, so four words per tile that has any walls
+    std::vector<u32> wall_masks_;
+
+    u16 cache_tag_[HEIGHTMAP_CACHE_TILES];
+    u8 cache_[HEIGHTMAP_CACHE_TILES][kTileCells];
+};
+
+}  // namespace physics
+
+#endif  // PHYSICS_HEIGHTMAP_H
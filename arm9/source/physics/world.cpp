@@ -4,9 +4,12 @@
 #include "debug/profiler.h"
 #include "debug/utilities.h"
 #include "body.h"
+#include "math_unit.h"
 #include "numeric_types.h"
 #include "vector.h"
 
+#include <new>
+
 #include "stdlib.h"
 
 using physics::World;
@@ -15,78 +18,190 @@ using physics::BodyHandle;
 using numeric_types::fixed;
 using numeric_types::literals::operator"" _f;
 
+// Broadphase query scratch. Hit at random for every pair test, so it lives in
+// DTCM rather than in the World itself, as long as the World is small enough.
+HOT_BSS int g_query_marks[PHYSICS_TCM_BODIES];
+HOT_BSS u16 g_candidates[PHYSICS_TCM_BODIES];
+
+namespace {
+
+// Slots, grid entries and contacts are all stored as u16
+const int kMaxCapacity = 0xFFFF /
+    (PHYSICS_GRID_ENTRIES_PER_BODY > PHYSICS_CONTACTS_PER_BODY ?
+    PHYSICS_GRID_ENTRIES_PER_BODY : PHYSICS_CONTACTS_PER_BODY);
+const int kMaxContacts = 0xFFFF;
+
+// Points array at the next suitably aligned spot and moves the cursor past it
+template <typename T>
+void Carve(uintptr_t& cursor, T*& array, int count) {
+  cursor = (cursor + alignof(T) - 1) & ~(uintptr_t)(alignof(T) - 1);
+  array = reinterpret_cast<T*>(cursor);
+  cursor += sizeof(T) * count;
+}
+
+}  // namespace
+
 World::World() {
   tMoveBodies =    debug::Profiler::RegisterTopic("Physics: Move Bodies");
   tCollideBodies = debug::Profiler::RegisterTopic("Physics: Collide Bodies");
   tCollideWorld =  debug::Profiler::RegisterTopic("Physics: Collide World");
+  tSettle =        debug::Profiler::RegisterTopic("Physics: Settle");
+  tBroadphase =    debug::Profiler::RegisterTopic("Physics: Broadphase");
+  tContacts =      debug::Profiler::RegisterTopic("Physics: Contacts");
 
   tAA = debug::Profiler::RegisterTopic("Physics: Bodies: A vs A");
   tAP = debug::Profiler::RegisterTopic("Physics: Bodies: A vs P");
   tPP = debug::Profiler::RegisterTopic("Physics: Bodies: P vs P");
+
+  Reserve(PHYSICS_DEFAULT_BODIES);
 }
 
 World::~World() {
+  free(storage_);
+  free(contact_spill_);
 }
 
-Body* World::AllocateBody(Handle owner) {
-  // This is a fairly naive implementation.
+uintptr_t World::LayOutStorage(uintptr_t base, int capacity) {
+  // Biggest alignment first, though Carve pads as needed either way
+  capacity_ = capacity;
+  grid_capacity_ = capacity * PHYSICS_GRID_ENTRIES_PER_BODY;
+  contact_capacity_ = capacity * PHYSICS_CONTACTS_PER_BODY;
+  uintptr_t cursor = base;
+  Carve(cursor, bodies_, capacity);
+  CarveContacts(cursor, contact_capacity_);
+  Carve(cursor, step_, capacity);
+  Carve(cursor, active_, capacity);
+  Carve(cursor, pikmin_, capacity);
+  Carve(cursor, list_position_, capacity);
+  Carve(cursor, free_, capacity);
+  Carve(cursor, global_list_, capacity);
+  Carve(cursor, cell_ranges_, capacity);
+  Carve(cursor, swarm_cells_, capacity);
+  Carve(cursor, grid_entries_, grid_capacity_);
+  Carve(cursor, swarm_sorted_, capacity);
+  Carve(cursor, contact_start_, capacity + 1);
+  if (capacity <= PHYSICS_TCM_BODIES) {
+    query_marks_ = g_query_marks;
+    candidates_ = g_candidates;
+  } else {
+    Carve(cursor, query_marks_, capacity);
+    Carve(cursor, candidates_, capacity);
+  }
+  Carve(cursor, listed_as_pikmin_, capacity);
+  Carve(cursor, global_, capacity);
+  return cursor - base;
+}
 
-  // Note: A return value of 0 (Null) indicates failure.
-  for (int i = 0; i < MAX_PHYSICS_BODIES; i++) {
-    if (bodies_[i].active == 0) {
-      Body default_zeroed = {};
-      bodies_[i] = default_zeroed;
-
-      bodies_[i].touching_ground = 0;
-      bodies_[i].is_sensor = 0;
-      bodies_[i].collides_with_bodies = 1;
-      bodies_[i].collides_with_level = 1;
-      bodies_[i].ignores_walls = 0;
-      bodies_[i].is_movable = 0;
-      bodies_[i].is_pikmin = 0;
-      bodies_[i].affected_by_gravity = 1;
-      bodies_[i].active = 1;
-      bodies_[i].is_very_important = 0;
-
-      bodies_[i].owner = owner;
-      bodies_[i].generation = current_generation_;
-      rebuild_index_ = true;
-
-      // Old-style handle, kept here for compatability reasons.
-      // TODO: Remove this when reliance on this handle is refactored out.
-      BodyHandle handle;
-      handle.body = &bodies_[i];
-      handle.generation = current_generation_;
-
-      // New-style handle, used for safer references to Physics bodies by
-      // non-owners.
-      bodies_[i].handle.id = i;
-      bodies_[i].handle.generation = current_generation_;
-      bodies_[i].handle.type = World::kBody;
-
-      // Clear out the neighbor list for newly created bodies, to avoid weirdness
-      for (int n = 0; n < MAX_PHYSICS_NEIGHBORS; n++) {
-        bodies_[i].neighbors[n].handle.generation = -1;
-      }
+void World::ResetStorage() {
+  for (int i = 0; i < capacity_; i++) {
+    new (&bodies_[i]) Body();
+    bodies_[i].active = 0;
+    global_[i] = false;
+    query_marks_[i] = 0;
+    // Hand out low slots first
+    free_[i] = capacity_ - 1 - i;
+  }
+  free_count_ = capacity_;
+  active_bodies_ = 0;
+  active_pikmin_ = 0;
+  current_query_ = 0;
+  ResetBroadphase();
+}
 
-      return &bodies_[i];
-    }
+bool World::Reserve(int capacity) {
+  if (capacity == capacity_) {
+    return true;
   }
-  return nullptr;
+  if (active_bodies_ + active_pikmin_ > 0) {
+    debug::Log("Can't resize the physics world with bodies in it");
+    return false;
+  }
+  if (capacity <= 0 or capacity > kMaxCapacity) {
+    debug::Log("Invalid physics body count: " + std::to_string(capacity));
+    return false;
+  }
+
+  // Give the old block back first, so a level that shrinks the world really
+  // does leave that memory to everything else
+  const int previous = capacity_;
+  free(storage_);
+  free(contact_spill_);
+  contact_spill_ = nullptr;
+  storage_ = malloc(LayOutStorage(0, capacity));
+  if (!storage_) {
+    debug::Log("Not enough memory for " + std::to_string(capacity) +
+        " physics bodies");
+    // This much was only just freed, so it fits
+    capacity = previous;
+    storage_ = malloc(LayOutStorage(0, capacity));
+  }
+  LayOutStorage((uintptr_t)storage_, capacity);
+  ResetStorage();
+  return capacity_ != previous;
+}
+
+int World::Capacity() const {
+  return capacity_;
+}
+
+Body* World::AllocateBody(Handle owner) {
+  // Note: A return value of 0 (Null) indicates failure.
+  if (free_count_ == 0) {
+    return nullptr;
+  }
+  int i = free_[--free_count_];
+
+  Body default_zeroed = {};
+  bodies_[i] = default_zeroed;
+
+  bodies_[i].touching_ground = 0;
+  bodies_[i].is_sensor = 0;
+  bodies_[i].collides_with_bodies = 1;
+  bodies_[i].collides_with_level = 1;
+  bodies_[i].ignores_walls = 0;
+  bodies_[i].is_movable = 0;
+  bodies_[i].is_pikmin = 0;
+  bodies_[i].affected_by_gravity = 1;
+  bodies_[i].sleeping = 0;
+  bodies_[i].active = 1;
+
+  bodies_[i].owner = owner;
+  bodies_[i].generation = current_generation_;
+
+  // Everything starts out as an object; SortLists moves it over if the owner
+  // marks it as a pikmin after the fact.
+  AddToList(i, false);
+
+  // Old-style handle, kept here for compatability reasons.
+  // TODO: Remove this when reliance on this handle is refactored out.
+  BodyHandle handle;
+  handle.body = &bodies_[i];
+  handle.generation = current_generation_;
+
+  // New-style handle, used for safer references to Physics bodies by
+  // non-owners.
+  bodies_[i].handle.id = i;
+  bodies_[i].handle.generation = current_generation_;
+  bodies_[i].handle.type = World::kBody;
+
+  return &bodies_[i];
 }
 
 void World::FreeBody(Body* body) {
-  if (body) {
+  if (body and body->active) {
+    int slot = body - bodies_;
+    RemoveFromList(slot);
+    free_[free_count_++] = slot;
+
     body->owner = Handle{};
     body->active = 0;
     body->handle.type = World::kNone;
-    rebuild_index_ = true;
     current_generation_++;
   }
 }
 
 Body* World::RetrieveBody(Handle handle) {
-  if (handle.id < MAX_PHYSICS_BODIES) {
+  if (handle.id < (unsigned int)capacity_) {
     Body* body = &bodies_[handle.id];
     if (body->active and body->handle.Matches(handle)) {
       return body;
@@ -96,40 +211,165 @@ Body* World::RetrieveBody(Handle handle) {
 }
 
 void World::ResetWorld() {
-  for (int i = 0; i < MAX_PHYSICS_BODIES; i++) {
+  for (int i = 0; i < capacity_; i++) {
     FreeBody(&bodies_[i]);
   }
-  RebuildIndex();
+  // Put the free list back in its starting order too, so slots get handed out
+  // exactly as they would be after a fresh boot. Replays depend on this.
+  for (int i = 0; i < capacity_; i++) {
+    free_[i] = capacity_ - 1 - i;
+  }
+  ResetBroadphase();
+}
+
+u32 World::Checksum() {
+  // FNV-1a over everything that moves, in list order
+  u32 hash = 2166136261u;
+  auto mix = [&hash](s32 value) {
+    hash = (hash ^ (u32)value) * 16777619u;
+  };
+  for (int list = 0; list < 2; list++) {
+    const int* slots = list ? pikmin_ : active_;
+    const int count = list ? active_pikmin_ : active_bodies_;
+    for (int i = 0; i < count; i++) {
+      const Body& body = bodies_[slots[i]];
+      mix(slots[i]);
+      mix(body.position.x.data_);
+      mix(body.position.y.data_);
+      mix(body.position.z.data_);
+      mix(body.velocity.x.data_);
+      mix(body.velocity.y.data_);
+      mix(body.velocity.z.data_);
+      mix(body.result_groups);
+    }
+  }
+  return hash;
 }
 
 void World::Wake(Body* body) {
-  body->active = 1;
-  rebuild_index_ = true;
+  body->sleeping = 0;
+  body->idle_frames = 0;
 }
 
 void World::Sleep(Body* body) {
-  body->active = 0;
-  rebuild_index_ = true;
+  body->sleeping = 1;
+  body->rest_position = body->position;
+  body->velocity = Vec3{0_f, 0_f, 0_f};
 }
 
-void World::RebuildIndex() {
-  active_bodies_ = 0;
-  active_pikmin_ = 0;
-  important_bodies_ = 0;
-  for (int i = 0; i < MAX_PHYSICS_BODIES; i++) {
-    if (bodies_[i].active) {
-      if (bodies_[i].is_very_important) {
-        important_[important_bodies_++] = i;
+void World::AddToList(int slot, bool pikmin) {
+  listed_as_pikmin_[slot] = pikmin;
+  if (pikmin) {
+    list_position_[slot] = active_pikmin_;
+    pikmin_[active_pikmin_++] = slot;
+  } else {
+    list_position_[slot] = active_bodies_;
+    active_[active_bodies_++] = slot;
+  }
+}
+
+void World::RemoveFromList(int slot) {
+  // Swap the last entry into our place. This shuffles the list order, which
+  // only matters for which body of a pair ends up resolving it.
+  int* list = active_;
+  int* count = &active_bodies_;
+  if (listed_as_pikmin_[slot]) {
+    list = pikmin_;
+    count = &active_pikmin_;
+  }
+  int position = list_position_[slot];
+  int last = list[--(*count)];
+  list[position] = last;
+  list_position_[last] = position;
+}
+
+void World::SortLists() {
+  // is_pikmin gets set by the owner after allocation, so move any bodies that
+  // changed category since the last step. Walk backwards, since removing
+  // swaps the tail into the current position.
+  for (int i = active_bodies_ - 1; i >= 0; i--) {
+    int slot = active_[i];
+    if (bodies_[slot].is_pikmin) {
+      RemoveFromList(slot);
+      AddToList(slot, true);
+    }
+  }
+  for (int i = active_pikmin_ - 1; i >= 0; i--) {
+    int slot = pikmin_[i];
+    if (!bodies_[slot].is_pikmin) {
+      RemoveFromList(slot);
+      AddToList(slot, false);
+    }
+  }
+}
+
+void World::MoveBody(Body& body) {
+  body.old_position = body.position;
+  body.woken = 0;
+
+  // Game code writes straight into the Body, so a sleeping body that has been
+  // moved or pushed since it fell asleep needs to wake up here.
+  if (body.sleeping and (!(body.velocity == Vec3{0_f, 0_f, 0_f}) or
+      !(body.acceleration == CompactVec3{}) or !(body.position == body.rest_position))) {
+    Wake(&body);
+  }
+  if (body.sleeping) {
+    return;
+  }
+
+  body.position += body.velocity;
+  body.velocity += body.acceleration.Widen();
+
+  // Gravity!
+  if (body.affected_by_gravity) {
+    body.velocity.y -= GRAVITY_CONSTANT;
+  }
+}
+
+void World::MoveBodies() {
+  // Objects first, then pikmin, so each group stays contiguous
+  step_count_ = 0;
+  for (int i = 0; i < active_bodies_; i++) {
+    Body& body = bodies_[active_[i]];
+    MoveBody(body);
+    step_[step_count_++] = &body;
+  }
+  step_objects_ = step_count_;
+  for (int i = 0; i < active_pikmin_; i++) {
+    Body& body = bodies_[pikmin_[i]];
+    MoveBody(body);
+    step_[step_count_++] = &body;
+  }
+}
+
+bool World::AtRest(Body& body) {
+  return body.touching_ground and
+      abs(body.position.x.data_ - body.old_position.x.data_) <= PHYSICS_SLEEP_EPSILON and
+      abs(body.position.y.data_ - body.old_position.y.data_) <= PHYSICS_SLEEP_EPSILON and
+      abs(body.position.z.data_ - body.old_position.z.data_) <= PHYSICS_SLEEP_EPSILON and
+      abs(body.velocity.x.data_) <= PHYSICS_SLEEP_EPSILON and
+      abs(body.velocity.z.data_) <= PHYSICS_SLEEP_EPSILON and
+      body.acceleration == CompactVec3{};
+}
+
+void World::SettleBodies() {
+  sleeping_bodies_ = 0;
+  for (int i = 0; i < step_count_; i++) {
+    Body& body = *step_[i];
+    if (body.sleeping) {
+      if (body.woken) {
+        Wake(&body);
       } else {
-        if (bodies_[i].is_pikmin) {
-          pikmin_[active_pikmin_++] = i;
-        } else {
-          active_[active_bodies_++] = i;
-        }
+        sleeping_bodies_++;
       }
+    } else if (AtRest(body)) {
+      if (++body.idle_frames >= PHYSICS_SLEEP_FRAMES) {
+        Sleep(&body);
+      }
+    } else {
+      body.idle_frames = 0;
     }
   }
-  rebuild_index_ = false;
 }
 
 bool World::BodiesOverlap(Body& a, Body& b) {
@@ -161,6 +401,10 @@ void World::ResolveCollision(Body& a, Body& b) {
   if (a.is_sensor or b.is_sensor) {
     return;
   }
+  // Two sleeping bodies have already settled whatever overlap they have
+  if (a.sleeping and b.sleeping) {
+    return;
+  }
   // One of the bodies must be able to respond to collisions
   if (a.is_movable || b.is_movable) {
     auto a_direction = (a.position - b.position);
@@ -176,20 +420,30 @@ void World::ResolveCollision(Body& a, Body& b) {
       a_direction.x = 1.0_f;
       a_direction.z = 1.0_f;
     }
+    // 1 / distance is worked out by the divider while we get everything else
+    // ready. Radii are never negative, so their eighths are just shifts.
+    math_unit::StartDivide((s64)(1_f).data_ << 12, distance.data_);
+    const fixed overlap = (a.radius + b.radius) - distance;
+    const fixed a_limit = fixed::FromRaw(a.radius.data_ >> 3);
+    const fixed b_limit = fixed::FromRaw(b.radius.data_ >> 3);
+    const fixed inverse_distance = fixed::FromRaw(math_unit::DivideResult());
     if (a.is_movable and (!(b.is_pikmin) or a.is_pikmin)) {
 
       // multiply, so that we move exactly the distance required to undo the
       // overlap between these objects
       // a_direction = a_direction.Normalize();
-      auto offset = (a.radius + b.radius) - distance;
-      if (offset > (b.radius / 8_f)) {
-        offset = b.radius / 8_f;
+      auto offset = overlap;
+      if (offset > b_limit) {
+        offset = b_limit;
       }
 
       a_direction *= offset;
-      a_direction *= 1_f / distance;
+      a_direction *= inverse_distance;
 
       a.position = a.position + a_direction;
+      if (a.sleeping) {
+        a.woken = 1;
+      }
     }
     if (b.is_movable and (!(a.is_pikmin) or b.is_pikmin)) {
       auto b_direction = (b.position - a.position);
@@ -200,53 +454,190 @@ void World::ResolveCollision(Body& a, Body& b) {
       // multiply, so that we move exactly the distance required to undo the
       // overlap between these objects
       //b_direction = b_direction.Normalize();
-      auto offset = (a.radius + b.radius) - distance;
-      if (offset > (a.radius / 8_f)) {
-        offset = a.radius / 8_f;
+      auto offset = overlap;
+      if (offset > a_limit) {
+        offset = a_limit;
       }
 
       b_direction *= offset;
-      b_direction *= 1_f / distance;
+      b_direction *= inverse_distance;
 
       b.position = b.position + b_direction;
+      if (b.sleeping) {
+        b.woken = 1;
+      }
     }
   }
 }
 
-void World::PrepareBody(Body& body) {
-  //set the old position (used later for comparison)
-  body.old_position = body.position;
-  body.old_radius = body.radius;
+void World::RecordSensorHit(int sensor, int listener) {
+  // Just note the pair; BuildContacts sorts it all out once collision is done.
+  if (raw_count_ < contact_capacity_ or GrowContacts(raw_count_ + 1)) {
+    raw_contacts_[raw_count_++] = {(u16)listener, (u16)sensor};
+  } else {
+    dropped_contacts_++;
+  }
+}
 
-  //clear sensor results for this run
-  body.result_groups = 0;
-  body.num_results = 0;
+void World::CarveContacts(uintptr_t& cursor, int capacity) {
+  Carve(cursor, contact_arena_[0], capacity);
+  Carve(cursor, contact_arena_[1], capacity);
+  Carve(cursor, raw_contacts_, capacity);
+  Carve(cursor, contact_sorted_, capacity);
 }
 
-void World::MoveBody(Body& body) {
-  body.position += body.velocity;
-  body.velocity += body.acceleration;
+bool World::GrowContacts(int needed) {
+  if (needed > kMaxContacts) {
+    return false;
+  }
+  // Leave room to spare, so a crowd that keeps on growing doesn't land here
+  // every step
+  int capacity = needed * 2;
+  if (capacity > kMaxContacts) {
+    capacity = kMaxContacts;
+  }
+  // Bring along this step's raw hits, and the half of the arena last step's
+  // contacts are in, since bodies still point into it. CarveContacts moves
+  // the pointers even when it's only measuring, so hold on to these first.
+  RawContact* old_raw = raw_contacts_;
+  CollisionResult* old_arena = contact_arena_[current_arena_];
+  CollisionResult* other_arena = contact_arena_[current_arena_ ^ 1];
+  u16* old_sorted = contact_sorted_;
+  uintptr_t size = 0;
+  CarveContacts(size, capacity);
+  void* spill = malloc(size);
+  if (!spill) {
+    contact_arena_[current_arena_] = old_arena;
+    contact_arena_[current_arena_ ^ 1] = other_arena;
+    raw_contacts_ = old_raw;
+    contact_sorted_ = old_sorted;
+    return false;
+  }
 
-  // Gravity!
-  if (body.affected_by_gravity) {
-    body.velocity.y -= GRAVITY_CONSTANT;
+  uintptr_t cursor = (uintptr_t)spill;
+  CarveContacts(cursor, capacity);
+  CollisionResult* new_arena = contact_arena_[current_arena_];
+  for (int r = 0; r < raw_count_; r++) {
+    raw_contacts_[r] = old_raw[r];
   }
+  for (int c = 0; c < contacts_; c++) {
+    new_arena[c] = old_arena[c];
+  }
+  for (int i = 0; i < step_count_; i++) {
+    Body& body = *step_[i];
+    if (body.results >= old_arena and body.results < old_arena + contacts_) {
+      body.results = new_arena + (body.results - old_arena);
+    }
+  }
+
+  free(contact_spill_);
+  contact_spill_ = spill;
+  contact_capacity_ = capacity;
+  return true;
 }
 
-void World::MoveBodies() {
-  for (int i = 0; i < active_bodies_; i++) {
-    // First, make sure this is an active body
-    PrepareBody(bodies_[active_[i]]);
-    MoveBody(bodies_[active_[i]]);
+void World::BuildContacts() {
+  // Every contact ending this step was current last step, so this step's
+  // half of the arena needs room for both
+  if (raw_count_ + contacts_ > contact_capacity_) {
+    GrowContacts(raw_count_ + contacts_);
   }
-  for (int i = 0; i < active_pikmin_; i++) {
-    // First, make sure this is an active body
-    PrepareBody(bodies_[pikmin_[i]]);
-    MoveBody(bodies_[pikmin_[i]]);
+
+  // Counting sort the raw hits by listener
+  for (int i = 0; i <= step_count_; i++) {
+    contact_start_[i] = 0;
+  }
+  for (int r = 0; r < raw_count_; r++) {
+    contact_start_[raw_contacts_[r].listener + 1]++;
+  }
+  for (int i = 0; i < step_count_; i++) {
+    contact_start_[i + 1] += contact_start_[i];
   }
+  for (int r = 0; r < raw_count_; r++) {
+    contact_sorted_[contact_start_[raw_contacts_[r].listener]++] = r;
+  }
+  // Every start now sits where the next listener's range begins, so shift
+  // them back down by one to recover the ranges.
+  for (int i = step_count_; i > 0; i--) {
+    contact_start_[i] = contact_start_[i - 1];
+  }
+  contact_start_[0] = 0;
+
+  current_arena_ ^= 1;
+  CollisionResult* arena = contact_arena_[current_arena_];
+  int written = 0;
+  for (int i = 0; i < step_count_; i++) {
+    Body& body = *step_[i];
+    // Still pointing into the other half of the arena, from last step
+    const CollisionResult* previous = body.results;
+    const int previous_count = body.num_results;
+
+    const int first = written;
+    u32 groups = 0;
+    u32 began = 0;
+    for (int e = contact_start_[i]; e < contact_start_[i + 1]; e++) {
+      if (written == contact_capacity_) {
+        dropped_contacts_++;
+        continue;
+      }
+      const int sensor = raw_contacts_[contact_sorted_[e]].sensor;
+      CollisionResult& result = arena[written++];
+      result.body = step_[sensor];
+      result.collision_group = result.body->collision_group;
+      result.generation = result.body->generation;
+      result.event = kContactBegin;
+      for (int p = 0; p < previous_count; p++) {
+        if (previous[p].body == result.body and
+            previous[p].generation == result.generation) {
+          result.event = kContactPersist;
+          break;
+        }
+      }
+      if (result.event == kContactBegin) {
+        began |= result.collision_group;
+      }
+      groups |= result.collision_group;
+    }
+    const int current = written - first;
+
+    // Anything we were touching last step and aren't now has ended
+    u32 ended = 0;
+    for (int p = 0; p < previous_count; p++) {
+      bool still_touching = false;
+      for (int c = first; c < first + current; c++) {
+        if (arena[c].body == previous[p].body and
+            arena[c].generation == previous[p].generation) {
+          still_touching = true;
+          break;
+        }
+      }
+      if (still_touching) {
+        continue;
+      }
+      if (written == contact_capacity_) {
+        dropped_contacts_++;
+        continue;
+      }
+      arena[written] = previous[p];
+      arena[written].event = kContactEnd;
+      written++;
+      ended |= previous[p].collision_group;
+    }
+
+    body.results = arena + first;
+    body.num_results = current;
+    body.num_ended = written - first - current;
+    body.result_groups = groups;
+    body.began_groups = began;
+    body.ended_groups = ended;
+  }
+  contacts_ = written;
+  raw_count_ = 0;
 }
 
-void World::CollideObjectWithObject(Body& A, Body& B) {
+void World::CollideObjectWithObject(int a, int b) {
+  Body& A = *step_[a];
+  Body& B = *step_[b];
   const bool a_senses_b = B.is_sensor and
       (B.collision_group & A.sensor_groups);
   const bool b_senses_a = A.is_sensor and
@@ -261,125 +652,369 @@ void World::CollideObjectWithObject(Body& A, Body& B) {
 
       //if A is a sensor that B cares about
       if (A.collision_group & B.sensor_groups) {
-        B.result_groups = B.result_groups | A.collision_group;
-        if (B.num_results < 8) {
-          B.collision_results[B.num_results++] = {&A, A.collision_group};
-        }
+        RecordSensorHit(a, b);
       }
       //if B is a sensor that A cares about
       if (B.collision_group & A.sensor_groups) {
-        A.result_groups = A.result_groups | B.collision_group;
-        if (A.num_results < 8) {
-          A.collision_results[A.num_results++] = {&B, B.collision_group};
-        }
+        RecordSensorHit(b, a);
       }
     }
   }
 }
 
-void World::CollidePikminWithObject(Body& P, Body& A) {
+void World::CollidePikminWithObject(int p, int a) {
+  Body& P = *step_[p];
+  Body& A = *step_[a];
   if ((A.is_sensor and (A.collision_group & P.sensor_groups)) or
       (not A.is_sensor)) {
     if (BodiesOverlap(A, P)) {
       ResolveCollision(A, P);
       if (A.collision_group & P.sensor_groups) {
-        P.result_groups = P.result_groups | A.collision_group;
-        if (P.num_results < 8) {
-          P.collision_results[P.num_results++] = {&A, A.collision_group};
+        RecordSensorHit(a, p);
+      }
+    }
+  }
+}
+
+void World::CollidePikminWithPikmin(int pikmin1, int pikmin2) {
+  Body& a = *step_[pikmin1];
+  Body& b = *step_[pikmin2];
+  if (a.sleeping and b.sleeping) {
+    return;
+  }
+  if (BodiesOverlap(a, b)) {
+    ResolveCollision(a, b);
+  }
+}
+
+// Broadphase cells are PHYSICS_CELL_SHIFT heightmap cells on a side. Work
+// directly on the raw 20.12 values so negative coordinates floor correctly.
+const int kCellShift = 12 + PHYSICS_CELL_SHIFT;
+const s32 kHalfCell = 1 << (kCellShift - 1);
+
+// Wide bodies covering more cells than this are tested against everything
+// instead; past this point the grid stops paying for itself.
+const int kMaxFootprintCells = 64;
+
+bool World::WideBody(fixed radius) {
+  return radius.data_ > kHalfCell;
+}
+
+World::CellRange World::CellsForBody(int index, bool query) {
+  const Vec3& position = step_[index]->position;
+  const fixed radius = step_[index]->radius;
+  CellRange range;
+  if (WideBody(radius)) {
+    // Wide bodies are inserted across their whole footprint, padded by half a
+    // cell so that the center of any narrow body they touch is covered. They
+    // query the same cells they occupy.
+    s32 reach = radius.data_ + kHalfCell;
+    range.min_x = (position.x.data_ - reach) >> kCellShift;
+    range.min_z = (position.z.data_ - reach) >> kCellShift;
+    range.max_x = (position.x.data_ + reach) >> kCellShift;
+    range.max_z = (position.z.data_ + reach) >> kCellShift;
+  } else {
+    // Narrow bodies live in the cell holding their center. Any two narrow
+    // bodies that touch are at most one cell apart, so queries look at the
+    // neighboring cells too.
+    s16 cell_x = position.x.data_ >> kCellShift;
+    s16 cell_z = position.z.data_ >> kCellShift;
+    int spread = query ? 1 : 0;
+    range.min_x = cell_x - spread;
+    range.min_z = cell_z - spread;
+    range.max_x = cell_x + spread;
+    range.max_z = cell_z + spread;
+  }
+  return range;
+}
+
+int World::Bucket(int cell_x, int cell_z) {
+  return (((u32)cell_x * 73856093u) ^ ((u32)cell_z * 19349663u)) &
+      (PHYSICS_GRID_BUCKETS - 1);
+}
+
+void World::RebuildBroadphase() {
+  // Counting sort of every non-pikmin body into the grid buckets. Pikmin are
+  // never inserted; they only ever ask the grid who is near them. Everything
+  // here works on step order, so objects are simply 0 to active_bodies_.
+  for (int b = 0; b <= PHYSICS_GRID_BUCKETS; b++) {
+    grid_start_[b] = 0;
+  }
+  global_bodies_ = 0;
+  int total_entries = 0;
+  for (int i = 0; i < active_bodies_; i++) {
+    CellRange range = CellsForBody(i, false);
+    int cells = (range.max_x - range.min_x + 1) * (range.max_z - range.min_z + 1);
+    if (cells > kMaxFootprintCells or
+        total_entries + cells > grid_capacity_) {
+      global_[i] = true;
+      global_list_[global_bodies_++] = i;
+      continue;
+    }
+    global_[i] = false;
+    cell_ranges_[i] = range;
+    total_entries += cells;
+    for (int z = range.min_z; z <= range.max_z; z++) {
+      for (int x = range.min_x; x <= range.max_x; x++) {
+        grid_start_[Bucket(x, z) + 1]++;
+      }
+    }
+  }
+
+  for (int b = 0; b < PHYSICS_GRID_BUCKETS; b++) {
+    grid_start_[b + 1] += grid_start_[b];
+    grid_cursor_[b] = grid_start_[b];
+  }
+
+  for (int i = 0; i < active_bodies_; i++) {
+    if (global_[i]) {
+      continue;
+    }
+    CellRange& range = cell_ranges_[i];
+    for (int z = range.min_z; z <= range.max_z; z++) {
+      for (int x = range.min_x; x <= range.max_x; x++) {
+        grid_entries_[grid_cursor_[Bucket(x, z)]++] = i;
+      }
+    }
+  }
+}
+
+int World::GatherCandidates(int index, u16* candidates) {
+  // Wide bodies and hash collisions can put the same body in several of the
+  // buckets we visit, so every query stamps what it has already reported.
+  current_query_++;
+  query_marks_[index] = current_query_;
+  int count = 0;
+
+  if (index < active_bodies_ and global_[index]) {
+    for (int other = 0; other < active_bodies_; other++) {
+      if (query_marks_[other] != current_query_) {
+        query_marks_[other] = current_query_;
+        candidates[count++] = other;
+      }
+    }
+    return count;
+  }
+
+  for (int i = 0; i < global_bodies_; i++) {
+    int other = global_list_[i];
+    if (query_marks_[other] != current_query_) {
+      query_marks_[other] = current_query_;
+      candidates[count++] = other;
+    }
+  }
+
+  CellRange range = CellsForBody(index, true);
+  for (int z = range.min_z; z <= range.max_z; z++) {
+    for (int x = range.min_x; x <= range.max_x; x++) {
+      int bucket = Bucket(x, z);
+      for (int e = grid_start_[bucket]; e < grid_start_[bucket + 1]; e++) {
+        int other = grid_entries_[e];
+        if (query_marks_[other] != current_query_) {
+          query_marks_[other] = current_query_;
+          candidates[count++] = other;
         }
       }
     }
   }
+  return count;
 }
 
-void World::CollidePikminWithPikmin(Body& pikmin1, Body& pikmin2) {
-  if ((int)pikmin1.position.x == (int)pikmin2.position.x and
-      (int)pikmin1.position.z == (int)pikmin2.position.z) {
-    if (BodiesOverlap(pikmin1, pikmin2)) {
-      ResolveCollision(pikmin1, pikmin2);
+void World::SortSwarm() {
+  // Same counting sort as the broadphase, but with each pikmin in exactly one
+  // cell. Cells are at least one unit, and at least as wide as the largest
+  // pikmin is across, so any two pikmin that touch are at most a cell apart.
+  for (int b = 0; b <= PHYSICS_GRID_BUCKETS; b++) {
+    swarm_start_[b] = 0;
+  }
+  swarm_reach_ = 0_f;
+  for (int p = active_bodies_; p < step_count_; p++) {
+    if (step_[p]->radius > swarm_reach_) {
+      swarm_reach_ = step_[p]->radius;
     }
   }
+  swarm_shift_ = 12;
+  while ((1 << swarm_shift_) < 2 * swarm_reach_.data_) {
+    swarm_shift_++;
+  }
+  for (int p = active_bodies_; p < step_count_; p++) {
+    SwarmCell& cell = swarm_cells_[p];
+    cell.x = step_[p]->position.x.data_ >> swarm_shift_;
+    cell.z = step_[p]->position.z.data_ >> swarm_shift_;
+    swarm_start_[Bucket(cell.x, cell.z) + 1]++;
+  }
+  for (int b = 0; b < PHYSICS_GRID_BUCKETS; b++) {
+    swarm_start_[b + 1] += swarm_start_[b];
+    swarm_cursor_[b] = swarm_start_[b];
+  }
+  for (int p = active_bodies_; p < step_count_; p++) {
+    const SwarmCell& cell = swarm_cells_[p];
+    swarm_sorted_[swarm_cursor_[Bucket(cell.x, cell.z)]++] = p;
+  }
 }
 
-void World::AddNeighborToObject(Body& object, Body& new_neighbor) {
-  // calculate the distance *squared* between this object and the current
-  // candidate for neighbor status
-  fixed distance = (object.position - new_neighbor.position).Length2();
-  // Adjust for the radius on both sides (we want the distance between the
-  // nearest potential edge collision)
-  //distance -= (object.radius + new_neighbor.radius);
-  // Loop through the list of neighbors and find the farthest away object
-  // that this object is closer than (if any). If we find an inactive slot,
-  // we bail early; it wins.
-  fixed biggest_valid_distance = -1000_f;
-  int farthest_index = -1;
-  for (int i = 0; i < MAX_PHYSICS_NEIGHBORS; i++) {
-    if (object.neighbors[i].handle.IsValid()) {
-      auto current_body = object.neighbors[i].handle.body;
-      // If this object already exists in the list
-      if (&new_neighbor == current_body) {
-        // Update this distance and STOP.
-        object.neighbors[i].distance = distance;
-        return;
+void World::SeparateSwarm() {
+  // Each pikmin looks at its own cell and the four "forward" neighbors, which
+  // visits every pair of neighboring cells exactly once. Buckets can hold
+  // other cells that hashed alike, so check the cell itself too.
+  const int kForward[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+  for (int p = active_bodies_; p < step_count_; p++) {
+    const SwarmCell cell = swarm_cells_[p];
+
+    int bucket = Bucket(cell.x, cell.z);
+    for (int e = swarm_start_[bucket]; e < swarm_start_[bucket + 1]; e++) {
+      int other = swarm_sorted_[e];
+      if (other > p and swarm_cells_[other].x == cell.x and
+          swarm_cells_[other].z == cell.z) {
+        CollidePikminWithPikmin(p, other);
       }
-      // Are we closer than this object, and is this object the farthest
-      // object we could replace?
-      if (object.neighbors[i].distance > distance and
-          object.neighbors[i].distance > biggest_valid_distance) {
-          farthest_index = i;
-          biggest_valid_distance = distance;
+    }
+
+    for (int n = 0; n < 4; n++) {
+      s16 x = cell.x + kForward[n][0];
+      s16 z = cell.z + kForward[n][1];
+      bucket = Bucket(x, z);
+      for (int e = swarm_start_[bucket]; e < swarm_start_[bucket + 1]; e++) {
+        int other = swarm_sorted_[e];
+        if (swarm_cells_[other].x == x and swarm_cells_[other].z == z) {
+          CollidePikminWithPikmin(p, other);
+        }
       }
-    } else {
-      // Note: we don't short-circuit here because if we did, we might miss
-      // a chance to find ourselves in the list. We need to look at every
-      // neighbor to avoid that scenario.
-      farthest_index = i;
-      biggest_valid_distance = 1000_f;
     }
   }
-  if (farthest_index > -1) {
-    object.neighbors[farthest_index].handle = new_neighbor.GetHandle();
-    object.neighbors[farthest_index].distance = distance;
+}
+
+void World::ResetBroadphase() {
+  // Leaves nothing for queries to find until the next Update
+  step_count_ = 0;
+  step_objects_ = 0;
+  global_bodies_ = 0;
+  raw_count_ = 0;
+  contacts_ = 0;
+  for (int b = 0; b <= PHYSICS_GRID_BUCKETS; b++) {
+    grid_start_[b] = 0;
+    swarm_start_[b] = 0;
   }
 }
 
-void World::UpdateNeighbors() {
-  // It's a bit weird that we do this check first, non? But it handles the
-  // case where bodies were deleted, moving the pointer off the end of the list.
-  if (current_neighbor_ >= active_bodies_) {
-    current_neighbor_ = 0;
+bool World::QueryHit(int index, const QueryShape& shape) {
+  if (query_marks_[index] == current_query_) {
+    return false;
   }
+  query_marks_[index] = current_query_;
 
-  Body& new_neighbor = bodies_[active_[current_neighbor_]];
-  for (int a = 0; a < active_bodies_; a++) {
-    Body& current_object = bodies_[active_[a]];
-    if (&new_neighbor != &current_object) {
-      AddNeighborToObject(current_object, new_neighbor);
+  // The grid is from the last Update, but the test itself uses the body as
+  // it is right now, in case the AI has moved it since.
+  Body& body = *step_[index];
+  if (!body.active or !(body.collision_group & shape.group_mask)) {
+    return false;
+  }
+  Vec2 offset = Vec2{body.position.x - shape.base.x, body.position.z - shape.base.z};
+  auto sum = body.radius + shape.radius;
+  if (offset.Length2() >= sum * sum) {
+    return false;
+  }
+  if (shape.check_height) {
+    return body.position.y + body.height >= shape.base.y and
+        shape.base.y + shape.height >= body.position.y;
+  }
+  return true;
+}
+
+int World::Query(const QueryShape& shape, Body** results, int max_results) {
+  current_query_++;
+  int count = 0;
+
+  // Objects: the ones too big for the grid, then the grid cells under the
+  // shape, padded by half a cell to catch the centers of narrow bodies.
+  for (int i = 0; i < global_bodies_ and count < max_results; i++) {
+    if (QueryHit(global_list_[i], shape)) {
+      results[count++] = step_[global_list_[i]];
+    }
+  }
+  s32 reach = shape.radius.data_ + kHalfCell;
+  int min_x = (shape.base.x.data_ - reach) >> kCellShift;
+  int min_z = (shape.base.z.data_ - reach) >> kCellShift;
+  int max_x = (shape.base.x.data_ + reach) >> kCellShift;
+  int max_z = (shape.base.z.data_ + reach) >> kCellShift;
+  if ((max_x - min_x + 1) * (max_z - min_z + 1) > step_objects_) {
+    // Cheaper to just look at everything
+    for (int i = 0; i < step_objects_ and count < max_results; i++) {
+      if (QueryHit(i, shape)) {
+        results[count++] = step_[i];
+      }
+    }
+  } else {
+    for (int z = min_z; z <= max_z; z++) {
+      for (int x = min_x; x <= max_x; x++) {
+        int bucket = Bucket(x, z);
+        for (int e = grid_start_[bucket]; e < grid_start_[bucket + 1] and
+            count < max_results; e++) {
+          if (QueryHit(grid_entries_[e], shape)) {
+            results[count++] = step_[grid_entries_[e]];
+          }
+        }
+      }
     }
   }
 
-  for (int p = 0; p < active_pikmin_; p++) {
-    Body& current_object = bodies_[pikmin_[p]];
-    AddNeighborToObject(current_object, new_neighbor);
+  // Pikmin: same idea, using the cells from the swarm sort
+  reach = shape.radius.data_ + swarm_reach_.data_;
+  min_x = (shape.base.x.data_ - reach) >> swarm_shift_;
+  min_z = (shape.base.z.data_ - reach) >> swarm_shift_;
+  max_x = (shape.base.x.data_ + reach) >> swarm_shift_;
+  max_z = (shape.base.z.data_ + reach) >> swarm_shift_;
+  if ((max_x - min_x + 1) * (max_z - min_z + 1) > step_count_ - step_objects_) {
+    for (int p = step_objects_; p < step_count_ and count < max_results; p++) {
+      if (QueryHit(p, shape)) {
+        results[count++] = step_[p];
+      }
+    }
+  } else {
+    for (int z = min_z; z <= max_z; z++) {
+      for (int x = min_x; x <= max_x; x++) {
+        int bucket = Bucket(x, z);
+        for (int e = swarm_start_[bucket]; e < swarm_start_[bucket + 1] and
+            count < max_results; e++) {
+          int p = swarm_sorted_[e];
+          if (swarm_cells_[p].x == x and swarm_cells_[p].z == z and
+              QueryHit(p, shape)) {
+            results[count++] = step_[p];
+          }
+        }
+      }
+    }
   }
-  current_neighbor_++;
+  return count;
+}
+
+int World::QueryCylinder(const Vec3& base, fixed radius, fixed height,
+    u32 group_mask, Body** results, int max_results) {
+  return Query(QueryShape{base, radius, height, true, group_mask}, results,
+      max_results);
+}
+
+int World::QueryRadius(const Vec3& center, fixed radius, u32 group_mask,
+    Body** results, int max_results) {
+  return Query(QueryShape{center, radius, 0_f, false, group_mask}, results,
+      max_results);
 }
 
 void World::ProcessCollision() {
-  UpdateNeighbors();
+  debug::Profiler::StartTopic(tBroadphase);
+  RebuildBroadphase();
+  debug::Profiler::EndTopic(tBroadphase);
 
+  // Any two bodies that overlap find each other through the grid, so each
+  // pair is handled exactly once, by whichever body has the lower index.
   debug::Profiler::StartTopic(tAA);
   for (int a = 0; a < active_bodies_; a++) {
-    Body& A = bodies_[active_[a]];
-    for (int b = 0; b < MAX_PHYSICS_NEIGHBORS; b++) {
-      BodyHandle B = A.neighbors[b].handle;
-      if (B.IsValid()) {
-        CollideObjectWithObject(A, *(B.body));
+    int count = GatherCandidates(a, candidates_);
+    for (int c = 0; c < count; c++) {
+      if (candidates_[c] > a) {
+        CollideObjectWithObject(a, candidates_[c]);
       }
     }
-    for (int i = 0; i < important_bodies_; i++) {
-      CollideObjectWithObject(A, bodies_[important_[i]]);
-    }
   }
   debug::Profiler::EndTopic(tAA);
 
@@ -387,39 +1022,27 @@ void World::ProcessCollision() {
   // Pikmin need to collide against all active bodies, but not with each other*
   //   *except sometimes
   debug::Profiler::StartTopic(tAP);
-  for (int p = 0; p < active_pikmin_; p++) {
-    Body& P = bodies_[pikmin_[p]];
-    for (int a = 0; a < MAX_PHYSICS_NEIGHBORS; a++) {
-      BodyHandle A = P.neighbors[a].handle;;
-      if (A.IsValid()) {
-        CollidePikminWithObject(P, *(A.body));
-      }
-    }
-    for (int i = 0; i < important_bodies_; i++) {
-      CollidePikminWithObject(P, bodies_[important_[i]]);
+  for (int p = active_bodies_; p < step_count_; p++) {
+    int count = GatherCandidates(p, candidates_);
+    for (int c = 0; c < count; c++) {
+      CollidePikminWithObject(p, candidates_[c]);
     }
   }
   debug::Profiler::EndTopic(tAP);
 
-  // Finally, collide 1/8 of the pikmin against the rest of the group.
-  // (This really doesn't need to be terribly accurate.)
+  // Finally, push apart pikmin that are crowding each other, to keep the
+  // swarm from clumping into a single point.
   debug::Profiler::StartTopic(tPP);
-  for (int p1 = iteration %  8; p1 < active_pikmin_; p1 += 8) {
-    Body& P1 = bodies_[pikmin_[p1]];
-    for (int p2 = 0; p2 < active_pikmin_; p2++) {
-      Body& P2 = bodies_[pikmin_[p2]];
-      CollidePikminWithPikmin(P1, P2);
-    }
-  }
+  SortSwarm();
+  SeparateSwarm();
   debug::Profiler::EndTopic(tPP);
 }
 
 void World::Update() {
   bodies_overlapping_ = 0;
   total_collisions_ = 0;
-  if (rebuild_index_) {
-    RebuildIndex();
-  }
+  dropped_contacts_ = 0;
+  SortLists();
   
   debug::Profiler::StartTopic(tMoveBodies);
   MoveBodies();
@@ -429,10 +1052,18 @@ void World::Update() {
   ProcessCollision();
   debug::Profiler::EndTopic(tCollideBodies);
 
+  debug::Profiler::StartTopic(tContacts);
+  BuildContacts();
+  debug::Profiler::EndTopic(tContacts);
+
   debug::Profiler::StartTopic(tCollideWorld);
   CollideBodiesWithLevel();
   debug::Profiler::EndTopic(tCollideWorld);
 
+  debug::Profiler::StartTopic(tSettle);
+  SettleBodies();
+  debug::Profiler::EndTopic(tSettle);
+
   iteration++;
 }
 
@@ -444,6 +1075,18 @@ int World::TotalCollisions() {
   return total_collisions_;
 }
 
+int World::SleepingBodies() {
+  return sleeping_bodies_;
+}
+
+int World::Contacts() {
+  return contacts_;
+}
+
+int World::DroppedContacts() {
+  return dropped_contacts_;
+}
+
 void World::DebugCircles() {
   for (int i = 0; i < active_bodies_; i++) {
     Body& body = bodies_[active_[i]];
@@ -454,45 +1097,34 @@ void World::DebugCircles() {
     if (body.is_sensor) {
       color = RGB5(31,31,0); //yellow for sensors
     }
+    if (WideBody(body.radius)) {
+      color = RGB5(15,31,31); //cyan for bodies spread across the grid
+    }
+    if (body.sleeping) {
+      color = RGB5(15,15,31); //blue for sleeping bodies
+    }
     debug::DrawCircle(body.position, body.radius, color, segments);
   }
   for (int i = 0; i < active_pikmin_; i++) {
     Body& body = bodies_[pikmin_[i]];
     //pick a color based on the state of this body
     rgb color = RGB5(31,15,15);
+    if (body.sleeping) {
+      color = RGB5(15,15,31);
+    }
     int segments = 6;
     debug::DrawCircle(body.position, body.radius, color, segments);
   }
-
-  for (int i = 0; i < important_bodies_; i++) {
-    Body& body = bodies_[important_[i]];
-    //pick a color based on the state of this body
-    rgb color = RGB5(15,31,31);
-    int segments = 12;
-    debug::DrawCircle(body.position, body.radius, color, segments);
-  }
-
-  // Draw relationships from the current neighbor
-  Body& A = bodies_[active_[current_neighbor_]];
-  for (int i = 0; i < MAX_PHYSICS_NEIGHBORS; i++) {
-    BodyHandle B = A.neighbors[i].handle;
-    if (B.IsValid()) {
-        debug::DrawLine(A.position, B.body->position, RGB5(0, 31, 0));
-    }
-  }
 }
 
 void World::CollideBodiesWithLevel() {
-  for (int i = 0; i < active_bodies_; i++) {
-    // First, make sure this is an active body
-    CollideBodyWithLevel(bodies_[active_[i]]);
-  }
-  for (int i = 0; i < active_pikmin_; i++) {
-    // First, make sure this is an active body
-    CollideBodyWithLevel(bodies_[pikmin_[i]]);
+  for (int i = 0; i < step_count_; i++) {
+    CollideBodyWithLevel(*step_[i]);
   }
 }
 
+const fixed kWallThreshold = 2_f; //this seems reasonable
+
 void World::GenerateHeightTable() {
   fixed height_step = 32_f / 128_f;
   for (int i = 0; i < 128; i++) {
@@ -500,23 +1132,18 @@ void World::GenerateHeightTable() {
   }
 }
 
-void World::SetHeightmap(const u8* raw_heightmap_data) {
-  heightmap_data = (u8*)(raw_heightmap_data + 8); // skip over width/height
-  int* heightmap_coords = (int*)raw_heightmap_data;
-  heightmap_width = heightmap_coords[0];
-  heightmap_height = heightmap_coords[1];
+void World::SetHeightmap(const u8* heightmap_data) {
+  if (!heightmap_.Load(heightmap_data)) {
+    debug::Log("Heightmap isn't in the tiled format, ignoring.");
+  }
   GenerateHeightTable();
+  heightmap_.BakeWalls(kWallThreshold.data_ / height_table_[1].data_);
 }
 
 // Given a world position, figured out the level's height within the loaded
 // height map
 fixed World::HeightFromMap(int hx, int hz) {
-  if (hx < 0) {hx = 0;}
-  if (hz < 0) {hz = 0;}
-  if (hx >= heightmap_width) {hx = heightmap_width - 1;}
-  if (hz >= heightmap_height) {hz = heightmap_height - 1;}
-
-  u8 height_index = heightmap_data[hz * heightmap_width + hx] & 0x7F;
+  u8 height_index = heightmap_.Sample(hx, hz) & 0x7F;
   return height_table_[height_index];
 }
 
@@ -530,15 +1157,18 @@ fixed World::HeightFromMap(const Vec3& position) {
   return HeightFromMap(hx, hz);
 }
 
-const fixed kWallThreshold = 2_f; //this seems reasonable
-
 void World::CollideBodyWithLevel(Body& body) {
   if (!body.collides_with_level) {
     return;
   }
 
-  if (!(body.ignores_walls)) {
-    CollideBodyWithTilemap(body, 4);
+  // Sleeping bodies are already resting on the level, unless bumped this step
+  if (body.sleeping and !body.woken) {
+    return;
+  }
+
+  if (!body.ignores_walls) {
+    CollideBodyWithTilemap(body, body.old_position, 4);
   }
 
   fixed current_level_height = HeightFromMap(body.position);
@@ -551,10 +1181,24 @@ void World::CollideBodyWithLevel(Body& body) {
   }
 }
 
-void World::CollideBodyWithTilemap(Body& body, int max_depth) {
+bool World::CrossesWall(int tile_x, int tile_z, bool moved_x, int step) {
+  // Walls are stored on the edge shared with the +X / +Z neighbor, so moving
+  // in the negative direction checks the neighbor's edge instead
+  if (moved_x) {
+    return heightmap_.WallEdges(step > 0 ? tile_x : tile_x - 1, tile_z) &
+        Heightmap::kWallPlusX;
+  }
+  return heightmap_.WallEdges(tile_x, step > 0 ? tile_z : tile_z - 1) &
+      Heightmap::kWallPlusZ;
+}
+
+void World::CollideBodyWithTilemap(Body& body, Vec3 old_position,
+    int max_depth) {
+  Vec3& position = body.position;
+
   // Note: tiles are 1 "unit" wide for collision purposes. This simplifies life.
-  int tile_diff_x = ((int)body.position.x - (int)body.old_position.x);
-  int tile_diff_z = ((int)body.position.z - (int)body.old_position.z);
+  int tile_diff_x = ((int)position.x - (int)old_position.x);
+  int tile_diff_z = ((int)position.z - (int)old_position.z);
   int tiles_traversed = abs(tile_diff_x) + abs(tile_diff_z) + 1;
 
   if (tiles_traversed <= 1) {
@@ -562,49 +1206,64 @@ void World::CollideBodyWithTilemap(Body& body, int max_depth) {
     return;
   }
 
+  if (tiles_traversed == 2) {
+    // By far the most common case: we stepped over exactly one edge, and the
+    // baked walls say whether there's anything there to hit. Only set up the
+    // full traversal below (divides and all) if there is.
+    bool moved_x = tile_diff_x != 0;
+    if (!CrossesWall((int)old_position.x, (int)old_position.z, moved_x,
+        moved_x ? tile_diff_x : tile_diff_z)) {
+      return;
+    }
+  }
+
   // Figure out our first intersection and step size for traversing the grid
-  Vec3 diff = body.old_position - body.position;
+  Vec3 diff = old_position - position;
 
+  // The steps are 1 / |diff| on each axis. Both divides are queued on the
+  // divider, with the fractions worked out while they run.
   fixed intersect_x_step, intersect_z_step, next_intersect_x, next_intersect_z;
+  const s64 kOne = (s64)(1_f).data_ << 12;
+  if (diff.x != 0_f) {
+    math_unit::StartDivide(kOne, abs(diff.x.data_));
+  }
+  fixed x_fraction = position.x - fixed::FromInt((int)position.x);
+  fixed z_fraction = position.z - fixed::FromInt((int)position.z);
+  fixed x_distance = diff.x > 0_f ? 1_f - x_fraction : x_fraction;
+  fixed z_distance = diff.z > 0_f ? 1_f - z_fraction : z_fraction;
+
   if (diff.x == 0_f) {
     intersect_x_step = 0_f;
     next_intersect_x = fixed::FromRaw(0x0FFFFFFF); // Effectively positive infinity
   } else {
-    fixed x_fraction = body.position.x - fixed::FromInt((int)body.position.x);
-    if (diff.x > 0_f) {
-      intersect_x_step = 1_f / diff.x;
-      next_intersect_x = (1_f - x_fraction) * intersect_x_step;
-    } else {
-      intersect_x_step = -1_f / diff.x;
-      next_intersect_x = x_fraction * intersect_x_step;
-    }
+    intersect_x_step = fixed::FromRaw(math_unit::DivideResult());
+  }
+  if (diff.z != 0_f) {
+    math_unit::StartDivide(kOne, abs(diff.z.data_));
+  }
+  if (diff.x != 0_f) {
+    next_intersect_x = x_distance * intersect_x_step;
   }
 
   if (diff.z == 0_f) {
     intersect_z_step = 0_f;
     next_intersect_z = fixed::FromRaw(0x0FFFFFFF); // Effectively positive infinity
   } else {
-    fixed z_fraction = body.position.z - fixed::FromInt((int)body.position.z);
-    if (diff.z > 0_f) {
-      intersect_z_step = 1_f / diff.z;
-      next_intersect_z = (1_f - z_fraction) * intersect_z_step;
-    } else {
-      intersect_z_step = -1_f / diff.z;
-      next_intersect_z = z_fraction * intersect_z_step;
-    }
+    intersect_z_step = fixed::FromRaw(math_unit::DivideResult());
+    next_intersect_z = z_distance * intersect_z_step;
   }
 
   // Now, iterate over all the tiles this object would intersect, and perform height checks as we go
-  int tile_x = (int)body.old_position.x;
-  int tile_z = (int)body.old_position.z;
+  int tile_x = (int)old_position.x;
+  int tile_z = (int)old_position.z;
 
   int step_x = (tile_diff_x > 0 ? 1 : -1);
   int step_z = (tile_diff_z > 0 ? 1 : -1);
   bool moved_x;
 
-  fixed current_level_height = HeightFromMap(body.old_position);
-
   for (int i = 1; i < tiles_traversed; i++) {
+    int from_x = tile_x;
+    int from_z = tile_z;
     if (next_intersect_x < next_intersect_z) {
       tile_x += step_x;
       next_intersect_x += intersect_x_step;
@@ -615,43 +1274,48 @@ void World::CollideBodyWithTilemap(Body& body, int max_depth) {
       moved_x = false;
     }
 
+    // Edges without a baked wall can't stop us, whatever our height
+    if (!CrossesWall(from_x, from_z, moved_x, moved_x ? step_x : step_z)) {
+      continue;
+    }
+
     // Check to see if this is a valid move, and otherwise handle the response
+    fixed current_level_height = HeightFromMap(from_x, from_z);
     fixed new_level_height = HeightFromMap(tile_x, tile_z);
-    if (body.position.y < new_level_height) {
+    if (position.y < new_level_height) {
       if (new_level_height - current_level_height > kWallThreshold) {
         // Wall collision here!
         Vec3 intersection;
         Vec3 new_position;
         if (moved_x) {
           fixed x_moved = next_intersect_x - intersect_x_step;          
-          intersection.x = body.old_position.x + (diff.x * x_moved);
-          intersection.y = body.old_position.y + (diff.y * x_moved);
-          intersection.z = body.old_position.z + (diff.z * x_moved);
+          intersection.x = old_position.x + (diff.x * x_moved);
+          intersection.y = old_position.y + (diff.y * x_moved);
+          intersection.z = old_position.z + (diff.z * x_moved);
 
           new_position.x = intersection.x;
-          new_position.y = body.position.y;
-          new_position.z = body.position.z;
+          new_position.y = position.y;
+          new_position.z = position.z;
         } else {          
           fixed z_moved = next_intersect_z - intersect_z_step;
-          intersection.x = body.old_position.x + (diff.x * z_moved);
-          intersection.y = body.old_position.y + (diff.y * z_moved);
-          intersection.z = body.old_position.z + (diff.z * z_moved);
+          intersection.x = old_position.x + (diff.x * z_moved);
+          intersection.y = old_position.y + (diff.y * z_moved);
+          intersection.z = old_position.z + (diff.z * z_moved);
 
-          new_position.x = body.position.x;
-          new_position.y = body.position.y;
+          new_position.x = position.x;
+          new_position.y = position.y;
           new_position.z = intersection.z;
         }
 
-        body.old_position = intersection;
-        body.position = new_position;
+        old_position = intersection;
+        position = new_position;
 
         if (max_depth > 1) {
-          CollideBodyWithTilemap(body, max_depth - 1);
+          CollideBodyWithTilemap(body, old_position, max_depth - 1);
         }
         return;
       }
     }
-    current_level_height = new_level_height;
   }
 
 }
@@ -2,7 +2,9 @@
 #define WORLD_H
 
 #include "body.h"
+#include "heightmap.h"
 #include "project_settings.h"
+#include "tcm.h"
 
 namespace physics {
 
@@ -16,11 +18,42 @@ class World {
     void DebugCircles();
     void ResetWorld();
 
+    // Sizes the world for this many bodies, giving the previous storage back
+    // to the heap first. Only allowed while the world is empty, since every
+    // Body moves. If the new size can't be allocated, the old one is kept and
+    // false is returned.
+    bool Reserve(int capacity);
+    int Capacity() const;
+
+    // Sleeping bodies are noticed when their position or velocity is written,
+    // but call Wake after touching anything else (acceleration, radius...)
+    void Wake(physics::Body* body);
+    void Sleep(physics::Body* body);
+
+    // Spatial queries against the bodies as of the last Update; anything
+    // allocated since won't be found until the next one. Every active body
+    // whose collision_group shares a bit with group_mask and which overlaps
+    // the shape is written to results, up to max_results, and the number
+    // written is returned. Nothing is allocated.
+    int QueryCylinder(const Vec3& base, numeric_types::fixed radius,
+        numeric_types::fixed height, u32 group_mask, Body** results,
+        int max_results);
+    // Same as above, but ignores height entirely.
+    int QueryRadius(const Vec3& center, numeric_types::fixed radius,
+        u32 group_mask, Body** results, int max_results);
+
+    // Hash of every active body's position and velocity, for checking that
+    // two runs stayed in step
+    u32 Checksum();
+
     // Metrics
     int BodiesOverlapping();
     int TotalCollisions();
+    int SleepingBodies();
+    int Contacts();
+    int DroppedContacts();
 
-    void SetHeightmap(const u8* raw_heightmap_data);
+    void SetHeightmap(const u8* heightmap_data);
     World();
     ~World();
 
@@ -29,48 +62,148 @@ class World {
       kBody
     };
   private:
-    bool BodiesOverlap(physics::Body& A, physics::Body& b);
-    void ResolveCollision(physics::Body& A, physics::Body& B);
-    void ProcessCollision();
-    void PrepareBody(Body& body);
     void MoveBody(Body& body);
     void MoveBodies();
-    void RebuildIndex();
-    void Wake(physics::Body* body);
-    void Sleep(physics::Body* body);
-    void CollideBodyWithLevel(physics::Body& body);
+    void SettleBodies();
+    void AddToList(int slot, bool pikmin);
+    void RemoveFromList(int slot);
+    void SortLists();
+    bool AtRest(Body& body);
+
+    // Everything from here down works on indices into step_, not slots.
+    HOT_CODE bool BodiesOverlap(Body& a, Body& b);
+    void ResolveCollision(Body& a, Body& b);
+    void RecordSensorHit(int sensor, int listener);
+    void CarveContacts(uintptr_t& cursor, int capacity);
+    bool GrowContacts(int needed);
+    void BuildContacts();
+    HOT_CODE void ProcessCollision();
+    void CollideBodyWithLevel(Body& body);
     void CollideBodiesWithLevel();
-    void CollideBodyWithTilemap(physics::Body& body, int max_depth);
-    void CollideObjectWithObject(physics::Body& A, physics::Body& B);
-    void CollidePikminWithObject(physics::Body& P, physics::Body& A);
-    void CollidePikminWithPikmin(physics::Body& pikmin1, physics::Body& pikmin2);
-    void UpdateNeighbors();
-    void AddNeighborToObject(Body& object, Body& new_neighbor);
+    HOT_CODE void CollideBodyWithTilemap(Body& body, Vec3 old_position,
+        int max_depth);
+    bool CrossesWall(int tile_x, int tile_z, bool moved_x, int step);
+    void CollideObjectWithObject(int a, int b);
+    void CollidePikminWithObject(int p, int a);
+    void CollidePikminWithPikmin(int pikmin1, int pikmin2);
+
+    // Broadphase: a uniform grid of cells, hashed into a fixed number of
+    // buckets and rebuilt from scratch every Update.
+    struct CellRange {
+      s16 min_x;
+      s16 min_z;
+      s16 max_x;
+      s16 max_z;
+    };
+    bool WideBody(numeric_types::fixed radius);
+    CellRange CellsForBody(int index, bool query);
+    int Bucket(int cell_x, int cell_z);
+    void RebuildBroadphase();
+    HOT_CODE int GatherCandidates(int index, u16* candidates);
+
+    // Swarm separation: pikmin are counting-sorted into cells sized to the
+    // largest of them every step, so each one only meets the pikmin in
+    // neighboring cells.
+    struct SwarmCell {
+      s16 x;
+      s16 z;
+    };
+    void SortSwarm();
+    HOT_CODE void SeparateSwarm();
+    void ResetBroadphase();
+
+    struct QueryShape {
+      Vec3 base;
+      numeric_types::fixed radius;
+      numeric_types::fixed height;
+      bool check_height;
+      u32 group_mask;
+    };
+    int Query(const QueryShape& shape, Body** results, int max_results);
+    bool QueryHit(int index, const QueryShape& shape);
 
     numeric_types::fixed HeightFromMap(const Vec3& position);
     numeric_types::fixed HeightFromMap(int hx, int hz);
     void GenerateHeightTable();
     numeric_types::fixed height_table_[128];
 
-    physics::Body bodies_[MAX_PHYSICS_BODIES];
+    // Everything sized by the capacity is carved out of a single allocation;
+    // see LayOutStorage.
+    uintptr_t LayOutStorage(uintptr_t base, int capacity);
+    void ResetStorage();
+    void* storage_ = nullptr;
+    int capacity_ = 0;
+    int grid_capacity_ = 0;
+    int contact_capacity_ = 0;
+
+    physics::Body* bodies_;
 
     int active_bodies_ = 0;
-    int active_[MAX_PHYSICS_BODIES];
+    int* active_;
     int active_pikmin_ = 0;
-    int pikmin_[MAX_PHYSICS_BODIES];
-    int important_bodies_ = 0;
-    int important_[MAX_PHYSICS_BODIES];
-
-    bool rebuild_index_ = true;
-    int heightmap_width = 0;
-    int heightmap_height = 0;
-    u8* heightmap_data = nullptr;
+    int* pikmin_;
+
+    // Kept up to date on every alloc and free, rather than rescanning the pool
+    int* list_position_;
+    bool* listed_as_pikmin_;
+    int free_count_ = 0;
+    int* free_;
+
+    // Every active body in the order this step visits them: objects first,
+    // then pikmin. Collision works on indices into this, so the broadphase,
+    // swarm and contacts can number bodies densely.
+    Body** step_;
+    int step_count_ = 0;
+    int step_objects_ = 0;  // Everything past this is a pikmin
+
+    u16 grid_start_[PHYSICS_GRID_BUCKETS + 1];
+    u16 grid_cursor_[PHYSICS_GRID_BUCKETS];
+    u16* grid_entries_;
+    CellRange* cell_ranges_;
+    bool* global_;
+    int global_bodies_ = 0;
+    int* global_list_;
+    int current_query_ = 0;
+    // Point at the DTCM scratch when the world is small enough to use it
+    int* query_marks_;
+    u16* candidates_;
+
+    u16 swarm_start_[PHYSICS_GRID_BUCKETS + 1];
+    u16 swarm_cursor_[PHYSICS_GRID_BUCKETS];
+    u16* swarm_sorted_;
+    SwarmCell* swarm_cells_;
+    numeric_types::fixed swarm_reach_;
+    int swarm_shift_ = 12;  // Cell size, as a shift on raw 20.12 positions
+
+    // Sensor hits are recorded in whatever order the pairs come up, then
+    // counting-sorted by listener into this step's half of the arena, so each
+    // Body gets one contiguous range. The other half still holds last step's
+    // contacts, which is what begin/persist/end are worked out against.
+    //
+    // The storage carved for these from the world's block covers ordinary
+    // steps. One that needs more moves them all out to contact_spill_, a heap
+    // block sized to fit, rather than losing contacts; they stay there until
+    // the world is next resized.
+    struct RawContact {
+      u16 listener;
+      u16 sensor;
+    };
+    RawContact* raw_contacts_;
+    int raw_count_ = 0;
+    u16* contact_start_;
+    u16* contact_sorted_;
+    CollisionResult* contact_arena_[2];
+    int current_arena_ = 0;
+    int contacts_ = 0;
+    int dropped_contacts_ = 0;
+    void* contact_spill_ = nullptr;
+
+    Heightmap heightmap_;
 
     int iteration = 0;
     int bodies_overlapping_ = 0;
     int total_collisions_ = 0;
-
-    int current_neighbor_ = 0;
+    int sleeping_bodies_ = 0;
 
     int current_generation_ = 0;
 
@@ -78,6 +211,9 @@ class World {
     int tMoveBodies;
     int tCollideBodies;
     int tCollideWorld;
+    int tSettle;
+    int tBroadphase;
+    int tContacts;
     int tAA;
     int tAP;
     int tPP;
@@ -6,7 +6,9 @@
 
 #include "debug/draw.h"
 #include "debug/flags.h"
+#include "debug/math_benchmark.h"
 #include "debug/profiler.h"
+#include "input_utils.h"
 #include "render/multipass_renderer.h"
 #include "dsgx.h"
 #include "level_loader.h"
@@ -32,6 +34,17 @@ using numeric_types::literals::operator"" _brad;
 using numeric_types::Brads;
 using numeric_types::fixed;
 
+namespace {
+
+// Counted by the vblank interrupt; drives the simulation clock
+volatile u32 g_vblank_count = 0;
+
+void CountVBlank() {
+  g_vblank_count++;
+}
+
+}  // namespace
+
 int PikminSave::PikminCount(PikminType type) {
   // Note to self: *Probably* shouldn't do it this way
   return ((int*)this)[(int)type - 1];
@@ -52,6 +65,9 @@ int PikminGame::TotalPikmin() {
 }
 
 PikminGame::PikminGame(MultipassRenderer& renderer) : renderer_{renderer} {
+  irqSet(IRQ_VBLANK, CountVBlank);
+  irqEnable(IRQ_VBLANK);
+
   camera_.game = this;
   ui_.game = this;
   ui_.debug_state.game = this;
@@ -62,6 +78,9 @@ PikminGame::PikminGame(MultipassRenderer& renderer) : renderer_{renderer} {
   debug::RegisterFlag("Draw Renderer Circles");
   debug::RegisterFlag("Skip VBlank");
   debug::RegisterFlag("Render First Pass Only");
+  debug::RegisterFlag("Render Top To Bottom");
+  debug::RegisterFlag("Record Input");
+  debug::RegisterFlag("Benchmark Math");
 
   debug::RegisterWorld(&world_);
   debug::RegisterRenderer(&renderer_);
@@ -118,6 +137,14 @@ Drawable* PikminGame::allocate_entity() {
   return entities_.back();
 }
 
+int PikminGame::SimulationRate() {
+  return simulation_rate_;
+}
+
+void PikminGame::SetSimulationRate(int steps_per_second) {
+  simulation_rate_ = steps_per_second;
+}
+
 unsigned int PikminGame::CurrentFrame() {
   return current_frame_;
 }
@@ -142,6 +169,7 @@ Handle PikminGame::SpawnObject(std::array<StateType, size>& object_list, int typ
   new_object.handle.type = type;
 
   new_object.active = true;
+  new_object.random.Seed(seed_ ^ (++spawn_count_ * 0x9E3779B1u));
 
   new_object.entity = allocate_entity();
   new_object.body = world_.AllocateBody(new_object.handle);
@@ -386,6 +414,8 @@ void PikminGame::RemoveEverything() {
 }
 
 void PikminGame::LoadLevel(std::string filename) {
+  current_level_ = filename;
+
   // Clean the slate!
   RemoveEverything();
   level_loader::LoadLevel(*this, filename);
@@ -409,7 +439,7 @@ void PikminGame::RunAi() {
       captain_ai::machine.RunLogic(*i);
       squad_ai::machine.RunLogic((*i).squad);
       i->Update();
-      i->whistle->set_position(i->whistle_body->position);
+      i->whistle->set_position(i->cursor_body->position);
       i->cursor->set_position(i->cursor_body->position);
       if (i->dead) {
         RemoveCaptain(i->handle);
@@ -428,6 +458,7 @@ void PikminGame::RunAi() {
       }
     }
   }
+  pikmin_ai::SteerPikmin(pikmin.data(), pikmin.size());
 
   for (unsigned int o = 0; o < onions.size(); o++) {
     onion_ai::machine.RunLogic(onions[o]);
@@ -469,11 +500,16 @@ void PikminGame::RunAi() {
   debug::Profiler::EndTopic(tAI);
 }
 
-void PikminGame::Step() {
+void PikminGame::RunPhase() {
   current_step_++;
   if (current_step_ % 2 == 0) {
-    // On even frames, run AI
-    scanKeys();
+    // First half of a simulation step: run AI. The engine snapshots where
+    // everything is first, so drawing can blend from there to wherever the AI
+    // puts things.
+    renderer_.Update();
+
+    input::Scan();
+    replay_.Input();
     ui::machine.RunLogic(ui_);
 
     if (IsPaused()) {
@@ -483,9 +519,7 @@ void PikminGame::Step() {
     RunAi();
     current_frame_++;
   } else {
-    // On odd frames, run the World, and update the engine bits
-    renderer_.Update();
-
+    // Second half: run the World
     if (!IsPaused()) {
       debug::Profiler::StartTopic(tPhysicsUpdate);
       world_.Update();
@@ -494,8 +528,115 @@ void PikminGame::Step() {
       // Update some debug details about the world
       DebugDictionary().Set("Physics: Bodies Overlapping: ", world().BodiesOverlapping());
       DebugDictionary().Set("Physics: Total Collisions: ", world().TotalCollisions());
+      DebugDictionary().Set("Physics: Sleeping Bodies: ", world().SleepingBodies());
+      DebugDictionary().Set("Physics: Contacts: ", world().Contacts());
+      DebugDictionary().Set("Physics: Dropped Contacts: ", world().DroppedContacts());
+    }
+
+    // Paused or not, so that recordings stay one word per half
+    if (replay_.mode() != debug::Replay::kOff) {
+      auto& topics = debug::Profiler::Topics();
+      replay_.Checksum(current_frame_, world_.Checksum(),
+          topics[tAI].timing.delta(), topics[tPhysicsUpdate].timing.delta());
     }
   }
+}
+
+void PikminGame::Restart(u32 seed) {
+  // Everything the simulation depends on goes back to how it was at boot, so
+  // that a recording made here replays the same from a fresh start.
+  seed_ = seed;
+  spawn_count_ = 0;
+  srand(seed);
+
+  ui_ = ui::UIState();
+  ui_.game = this;
+  ui_.debug_state.game = this;
+  camera_ = camera_ai::CameraState();
+  camera_.game = this;
+
+  LoadLevel(current_level_);
+
+  current_frame_ = 0;
+  current_step_ = 0;
+  sim_backlog_ = 0;
+  input::Set(0, touchPosition{});
+  input::Set(0, touchPosition{});
+}
+
+void PikminGame::StartRecording() {
+  u32 seed = g_vblank_count;
+  if (replay_.StartRecording(REPLAY_RECORD_FILE, seed, current_level_)) {
+    Restart(seed);
+  }
+}
+
+bool PikminGame::StartReplay(std::string filename) {
+  if (!replay_.StartReplay(filename, REPLAY_CHECKSUM_FILE)) {
+    return false;
+  }
+  current_level_ = replay_.level();
+  Restart(replay_.seed());
+  return true;
+}
+
+void PikminGame::Step() {
+  // Recording always starts over from the top of the level
+  bool recording = replay_.mode() == debug::Replay::kRecording;
+  if (debug::Flag("Record Input") != recording) {
+    if (recording) {
+      replay_.Stop();
+    } else {
+      StartRecording();
+    }
+  }
+
+  // One-shot: run it, then put the flag back down
+  if (debug::Flag("Benchmark Math")) {
+    debug::BenchmarkMath();
+    debug::FlagList()["Benchmark Math"] = false;
+  }
+
+  // Each simulation step is split into an AI half and a physics half, which
+  // normally land on alternate vblanks. Time is counted in units where one
+  // vblank is worth two steps' worth of simulation_rate_, and one half costs
+  // kVBlankRate units; at 30 steps a second that's exactly one half per
+  // vblank. If a frame overruns, catch up by running several halves back to
+  // back, up to a limit, past which the game slows down instead.
+  const int kVBlankRate = 60;
+  const int kMaxBacklog = MAX_SIMULATION_SUBSTEPS * 2 * kVBlankRate;
+  u32 now = g_vblank_count;
+  int elapsed = now - last_vblank_;
+  last_vblank_ = now;
+  // Called again within the same vblank, elapsed is 0 and no halves run; the
+  // interpolation below still places the frame correctly
+  sim_backlog_ += elapsed * 2 * simulation_rate_;
+  if (sim_backlog_ > kMaxBacklog) {
+    sim_backlog_ = kMaxBacklog;
+  }
+  int halves = 0;
+  while (sim_backlog_ >= kVBlankRate) {
+    sim_backlog_ -= kVBlankRate;
+    RunPhase();
+    halves++;
+  }
+  DebugDictionary().Set("Sim Halves: ", halves);
+
+  // Drawables change during the AI half, so measure how far we are past the
+  // last one, as a fraction of a whole step.
+  int since_ai = sim_backlog_;
+  if (current_step_ % 2 == 1) {
+    since_ai += kVBlankRate;
+  }
+  renderer_.SetInterpolation(
+      fixed::FromRaw((since_ai << 12) / (2 * kVBlankRate)));
+
+  // Takes effect from the next frame the renderer starts
+  renderer_.UseTopToBottom(debug::Flag("Render Top To Bottom"));
+  DebugDictionary().Set("Render: Strategy: ", std::string(renderer_.StrategyName()));
+  DebugDictionary().Set("Render: Passes: ", renderer_.PassesLastFrame());
+  DebugDictionary().Set("Render: Dropped Frames: ", renderer_.DroppedFrames());
+  DebugDictionary().Set("Render: Quality Level: ", renderer_.QualityLevel());
 
   // Update basic system level debug info:
   struct mallinfo mi = mallinfo();
@@ -1,6 +1,7 @@
 #ifndef PIKMIN_GAME_H
 #define PIKMIN_GAME_H
 
+#include <array>
 #include <list>
 #include <map>
 
@@ -16,6 +17,7 @@
 #include "debug/ai_profiler.h"
 #include "debug/utilities.h"
 #include "debug/dictionary.h"
+#include "debug/replay.h"
 #include "physics/world.h"
 #include "drawable.h"
 #include "dsgx_allocator.h"
@@ -63,6 +65,11 @@ class PikminGame {
 
   unsigned int CurrentFrame();
 
+  // Simulation steps (AI + physics) per second, independent of how many
+  // vblanks each rendered frame takes.
+  int SimulationRate();
+  void SetSimulationRate(int steps_per_second);
+
   MultipassRenderer& renderer();
   physics::World& world();
 
@@ -134,6 +141,13 @@ class PikminGame {
   void RemoveEverything();
   void LoadLevel(std::string filename);
 
+  // Reloads the current level and records every step's input from there on,
+  // to REPLAY_RECORD_FILE. Also started by the "Record Input" debug flag.
+  void StartRecording();
+  // Plays back a recording made by StartRecording, from the same starting
+  // point, logging a checksum per frame. Returns false if there's no file.
+  bool StartReplay(std::string filename);
+
   camera_ai::CameraState& camera();
 
 private:
@@ -157,6 +171,8 @@ private:
   MultipassRenderer& renderer_;
 
   void RunAi();
+  void RunPhase();
+  void Restart(u32 seed);
 
   template <typename StateType>
   StateType* InitObject() {
@@ -183,6 +199,16 @@ private:
 
   int current_frame_{0};
   int current_step_{0};
+
+  int simulation_rate_{SIMULATION_RATE};
+  u32 last_vblank_{0};
+  int sim_backlog_{0};
+
+  // Everything random in the game derives from this
+  u32 seed_{1};
+  u32 spawn_count_{0};
+  std::string current_level_;
+  debug::Replay replay_;
 };
 
 #endif  // GAME_H
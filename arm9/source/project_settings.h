@@ -25,13 +25,33 @@
 #define MAX_OBJECTS_PER_PASS 35
 #endif
 
+// Passes the frame rate governor (see render/governor.h) aims to finish each
+// frame in. Every pass takes a vblank, so 3 holds the game at 20fps; past that
+// it starts trading detail away to keep the frame rate.
+#ifndef TARGET_PASSES_PER_FRAME
+#define TARGET_PASSES_PER_FRAME 3
+#endif
+
 // Maximum number of entities, total. Used to initialize various structs
 // in the multipass engine, acts as a limiter for both scene objects and
-// static bits of a level.
+// static bits of a level. The renderer's lists are fixed at this size, so
+// entities added past it are never drawn (the first one is logged.)
 #ifndef MAX_ENTITIES
 #define MAX_ENTITIES 256
 #endif
 
+// Meshes with lower detail versions (see Dsgx::CollectLevelsOfDetail) step
+// down a level every this many bounding radii away from the camera.
+#ifndef LOD_DISTANCE_PER_RADIUS
+#define LOD_DISTANCE_PER_RADIUS 24
+#endif
+
+// Meshes that have impostors (see render/impostors.h) are drawn as a single
+// sprite past this depth.
+#ifndef IMPOSTOR_DEPTH
+#define IMPOSTOR_DEPTH 96
+#endif
+
 // Maxiumum number of particles the engine can handle at once. Any particles
 // spawned above this limit silently fail.
 #ifndef MAX_PARTICLES
@@ -44,16 +64,89 @@
 #define FIELD_OF_VIEW 45.0_brad
 #endif
 
-// Maximum number of Physics Bodies that can be declared.
-#ifndef MAX_PHYSICS_BODIES
-#define MAX_PHYSICS_BODIES 256
+// Simulation steps per second. Each step runs the AI and then the physics,
+// normally on alternate vblanks.
+#ifndef SIMULATION_RATE
+#define SIMULATION_RATE 30
+#endif
+
+// After a long frame, at most this many simulation steps are run back to back
+// to catch up. Anything beyond that is dropped, and the game slows down.
+#ifndef MAX_SIMULATION_SUBSTEPS
+#define MAX_SIMULATION_SUBSTEPS 3
+#endif
+
+// Input recordings, for replaying a session exactly (see debug/replay.h.) A
+// recording is written to REPLAY_RECORD_FILE while the "Record Input" flag is
+// set. If REPLAY_INPUT_FILE exists at boot it is played back, and a checksum
+// per frame is written to REPLAY_CHECKSUM_FILE.
+#ifndef REPLAY_RECORD_FILE
+#define REPLAY_RECORD_FILE "/record.rec"
+#endif
+#ifndef REPLAY_INPUT_FILE
+#define REPLAY_INPUT_FILE "/replay.rec"
+#endif
+#ifndef REPLAY_CHECKSUM_FILE
+#define REPLAY_CHECKSUM_FILE "/replay.sum"
+#endif
+
+// Number of physics bodies a level gets unless it asks for a different number
+// with a "bodies" command. The world allocates everything it keeps per body
+// (the pool itself, step arrays, broadphase entries and contacts) from one
+// block sized by this.
+#ifndef PHYSICS_DEFAULT_BODIES
+#define PHYSICS_DEFAULT_BODIES 256
+#endif
+
+// Worlds up to this many bodies keep their broadphase scratch in DTCM; larger
+// ones fall back to main RAM for it.
+#ifndef PHYSICS_TCM_BODIES
+#define PHYSICS_TCM_BODIES 256
+#endif
+
+// Size of a broadphase cell, as a power of two in world units (and therefore
+// heightmap cells.) Bodies with a radius up to half a cell are bucketed by
+// their center alone; anything larger is inserted across its whole footprint.
+#ifndef PHYSICS_CELL_SHIFT
+#define PHYSICS_CELL_SHIFT 3
+#endif
+
+// Number of hash buckets the broadphase grid folds its cells into. Must be a
+// power of two.
+#ifndef PHYSICS_GRID_BUCKETS
+#define PHYSICS_GRID_BUCKETS 256
+#endif
+
+// Cell entries the broadphase may write in one frame, per body the world can
+// hold. Bodies that would not fit are tested against everything instead.
+#ifndef PHYSICS_GRID_ENTRIES_PER_BODY
+#define PHYSICS_GRID_ENTRIES_PER_BODY 4
+#endif
+
+// Sensor contacts the physics engine makes room for in one step, per body the
+// world can hold, shared across all bodies. Ended contacts from the step
+// before count against this too. A step that needs more moves the contacts out
+// to a larger block on the heap.
+#ifndef PHYSICS_CONTACTS_PER_BODY
+#define PHYSICS_CONTACTS_PER_BODY 2
+#endif
+
+// Bodies resting on the ground for this many physics steps are put to sleep,
+// skipping integration and level collision until something disturbs them.
+#ifndef PHYSICS_SLEEP_FRAMES
+#define PHYSICS_SLEEP_FRAMES 15
+#endif
+
+// How far a body may drift along any axis in one step (raw 20.12 units) and
+// still count as resting.
+#ifndef PHYSICS_SLEEP_EPSILON
+#define PHYSICS_SLEEP_EPSILON 4
 #endif
 
-// Number of physics neighbors to consider. Increasing this gives more accuracy
-// when many objects are near each other, but decreases performance heavily.
-// Shoot for something low but reasonable here.
-#ifndef MAX_PHYSICS_NEIGHBORS
-#define MAX_PHYSICS_NEIGHBORS 6
+// Number of decoded heightmap tiles kept around for level collision. Each one
+// costs 64 bytes. Must be a power of two.
+#ifndef HEIGHTMAP_CACHE_TILES
+#define HEIGHTMAP_CACHE_TILES 16
 #endif
 
 // How fast objects accelerate towards the ground, per frame
@@ -66,7 +159,6 @@
 #define PIKMIN_GROUP  (0x1 << 1)
 #define WHISTLE_GROUP (0x1 << 2)
 #define ATTACK_GROUP (0x1 << 3)
-#define DETECT_GROUP (0x1 << 4)
 #define ONION_FEET_GROUP (0x1 << 5)
 #define ONION_BEAM_GROUP (0x1 << 6)
 #define FIRE_HAZARD_GROUP (0x1 << 7)
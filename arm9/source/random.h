@@ -0,0 +1,34 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <nds/ndstypes.h>
+
+// A small xorshift generator. Every game object carries its own, seeded from
+// the game's seed and how many objects the game has spawned before it (not
+// its slot, which gets reused), so what one object rolls never depends on how
+// many numbers anything else has drawn. That keeps recorded sessions
+// replaying exactly.
+class Random {
+ public:
+  void Seed(u32 seed) {
+    // xorshift gets stuck on zero
+    state_ = seed ? seed : 0x9E3779B9;
+  }
+
+  u32 Next() {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return state_;
+  }
+
+  // Somewhere from 0 to range - 1
+  int Range(int range) {
+    return Next() % range;
+  }
+
+ private:
+  u32 state_{0x9E3779B9};
+};
+
+#endif  // RANDOM_H
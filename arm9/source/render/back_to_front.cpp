@@ -1,8 +1,11 @@
 #include "render/back_to_front.h"
 
+#include <algorithm>
+
 #include "render/multipass_renderer.h"
 #include "drawable.h"
 #include "numeric_types.h"
+#include "project_settings.h"
 
 using numeric_types::literals::operator"" _f;
 using numeric_types::fixed;
@@ -13,50 +16,187 @@ using numeric_types::Brads;
 namespace render {
 
 void BackToFront::GatherDrawList(MultipassRenderer& renderer) {
-  // Set the projection matrix to a full frustrum so that the list can be sorted
-  // without having to accout for errors caused by the clip plane.
-  renderer.ClipFriendlyPerspective(0.1_f, 256.0_f, renderer.cached_camera_fov_);
-
-  // Shift into camera space for the following tests
-  glLoadIdentity();
-  renderer.ApplyCameraTransform();
-
-  for (auto entity : renderer.entities_) {
-    // Cache the object so its render information stays the same across
-    // multiple passes.
-    entity->SetCache();
-    DrawState& state = entity->GetCachedState();
-
-    if (entity->InsideViewFrustrum()) {
-      // Using the camera state, calculate the nearest and farthest points,
-      // which we'll later use to decide where the clipping planes should go.
-      EntityContainer container;
-      container.entity = entity;
-      fixed object_z = entity->GetRealModelZ();
-      if (entity->important) {
-        container.far_z  = object_z + state.current_mesh->bounding_radius;
-        container.near_z = object_z - state.current_mesh->bounding_radius;
-      } else {
-        container.far_z  = object_z;
-        container.near_z = object_z;
-      }
-
-      entity->visible = true;
-      entity->overlaps = 0;
+  for (auto& view : renderer.visible_) {
+    Drawable* entity = view.entity;
+    if (renderer.governor_.ThinnedOut(entity->important, view.depth,
+        entity->render_id)) {
+      entity->visible = false;
+      continue;
+    }
 
-      renderer.draw_list_.push(container);
+    // Using the camera state, calculate the nearest and farthest points,
+    // which we'll later use to decide where the clipping planes should go.
+    EntityContainer container;
+    container.entity = entity;
+    if (entity->important) {
+      container.far_z  = view.depth + view.radius;
+      container.near_z = view.depth - view.radius;
     } else {
-      entity->visible = false;
+      container.far_z  = view.depth;
+      container.near_z = view.depth;
+    }
+
+    renderer.draw_list_.push_back(container);
+  }
+  renderer.SortDrawList();
+}
+
+bool BackToFront::FartherNearEdge(const Extent& a, const Extent& b) {
+  return a.near_z < b.near_z;
+}
+
+void BackToFront::PlanPasses(MultipassRenderer& renderer) {
+  // Everything here is in drawing order, farthest first, which is the draw
+  // list back to front. plan_[i] describes the point just before entity i.
+  auto& list = renderer.draw_list_;
+  const int count = list.size();
+  auto entity_at = [&list, count](int i) -> EntityContainer& {
+    return list[count - 1 - i];
+  };
+
+  plan_.resize(count + 1);
+  important_.clear();
+  int polycount = 0;
+  int overlap = 0;
+  for (int i = 0; i <= count; i++) {
+    PlanStep& step = plan_[i];
+    step.polycount = polycount;
+    step.overlap = 0;
+    step.passes = -1;
+    if (i == count) {
+      step.can_split = true;
+      break;
+    }
+    int cost = entity_at(i).entity->DrawCost();
+    polycount += cost;
+
+    // The first pass always starts at the back of the view. Later ones start
+    // at an entity's far edge, which has to be strictly nearer than the one
+    // before it; two passes sharing a clip plane is what used to drop frames.
+    // Nor can a pass start right at the camera.
+    step.split = entity_at(i).far_z;
+    if (step.split > 256_f) {
+      step.split = 256_f;
+    }
+    if (step.split < 0.1_f) {
+      step.split = 0.1_f;
+    }
+    step.can_split = i == 0 or
+        (step.split < plan_[i - 1].split and step.split > 0.1_f);
+
+    // Only important entities have any depth to them, so only they can reach
+    // across a split. Splits only ever move nearer, so once one no longer
+    // reaches past the split it never will again. important_ is a heap with
+    // the farthest near edge on top, and overlap the cost of what's left.
+    while (not important_.empty() and
+        not (important_[0].near_z < step.split)) {
+      std::pop_heap(important_.begin(), important_.end(), FartherNearEdge);
+      overlap -= important_.back().cost;
+      important_.pop_back();
+    }
+    if (step.can_split) {
+      step.overlap = overlap;
+    }
+    if (entity_at(i).entity->important) {
+      important_.push_back(Extent{entity_at(i).near_z, cost});
+      std::push_heap(important_.begin(), important_.end(), FartherNearEdge);
+      overlap += cost;
+    }
+  }
+
+  // For every place a pass could end, find the best plan that ends one there.
+  // A pass's cost only depends on where it starts and ends, so this builds on
+  // the best plans ending at each possible start.
+  plan_[0].passes = 0;
+  plan_[0].drawn = 0;
+  int last_start = 0;
+  for (int end = 1; end <= count; end++) {
+    PlanStep& step = plan_[end];
+    if (not step.can_split) {
+      continue;
     }
+    for (int start = end - 1; start >= 0; start--) {
+      int new_polygons = step.polycount - plan_[start].polycount;
+      if (end - start > MAX_OBJECTS_PER_PASS or
+          new_polygons > MAX_POLYGONS_PER_PASS) {
+        break;
+      }
+      const PlanStep& from = plan_[start];
+      if (not from.can_split) {
+        continue;
+      }
+      int pass_polygons = new_polygons + from.overlap;
+      if (pass_polygons > MAX_POLYGONS_PER_PASS) {
+        continue;
+      }
+      int passes = from.passes + 1;
+      int drawn = from.drawn + pass_polygons;
+      if (step.passes < 0 or passes < step.passes or
+          (passes == step.passes and drawn < step.drawn)) {
+        step.passes = passes;
+        step.drawn = drawn;
+        step.from = start;
+      }
+    }
+    if (step.passes < 0) {
+      // Nothing fits; usually a crowd of entities at the same depth. Draw the
+      // smallest pass that can end here anyway and let it go over, rather
+      // than drop the frame.
+      const PlanStep& from = plan_[last_start];
+      step.passes = from.passes + 1;
+      step.drawn = from.drawn + step.polycount - from.polycount + from.overlap;
+      step.from = last_start;
+    }
+    last_start = end;
   }
+
+  // Walk back from the end to find each pass's size
+  pass_sizes_.clear();
+  for (int end = count; end > 0; end = plan_[end].from) {
+    pass_sizes_.push_back(end - plan_[end].from);
+  }
+  std::reverse(pass_sizes_.begin(), pass_sizes_.end());
+  next_pass_ = 0;
 }
 
 void BackToFront::InitializeRender(MultipassRenderer& renderer) {
   GatherDrawList(renderer);
+  PlanPasses(renderer);
+}
+
+bool BackToFront::DrawPartition(MultipassRenderer& renderer, int partition) {
+  unsigned int initial_length = renderer.draw_list_.size();
+  unsigned int pass_size = 0;
+  if (next_pass_ < pass_sizes_.size()) {
+    pass_size = pass_sizes_[next_pass_++];
+  }
+  renderer.GatherPassList(pass_size);
+
+  if (not renderer.ProgressMadeThisPass(initial_length)) {
+    renderer.BailAndResetFrame();
+    return false;
+  }
+
+  renderer.SetupDividingPlane();
+
+  if (not renderer.ValidateDividingPlane()) {
+    return false;
+  }
+
+  renderer.DrawPassList();
+  return true;
 }
 
-void BackToFront::DrawPartition(MultipassRenderer& renderer, int partition, bool last_partition) {
+bool BackToFront::FrameComplete(MultipassRenderer& renderer) {
+  return renderer.draw_list_.empty();
+}
+
+void BackToFront::AbandonFrame(MultipassRenderer& renderer) {
+  renderer.ClearDrawList();
+}
 
+const char* BackToFront::Name() {
+  return "Back to Front";
 }
 
 } // namespace render
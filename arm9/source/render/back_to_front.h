@@ -1,16 +1,59 @@
 #ifndef RENDER_BACK_TO_FRONT_H
 #define RENDER_BACK_TO_FRONT_H
 
+#include "numeric_types.h"
+#include "project_settings.h"
+#include "render/fixed_vector.h"
 #include "render/strategy.h"
 
 namespace render {
 
+// Sorts everything by depth and draws it in slices from the back of the scene
+// forward, moving the far clip plane up to where the last pass left off.
+// Anything that pokes out in front of a slice is drawn again in the next one.
+//
+// Where the slices go is planned once per frame, over the whole draw list:
+// as few passes as fit the budget, and of those, the one that redraws the
+// fewest polygons.
 class BackToFront : public Strategy {
   public:
     void InitializeRender(MultipassRenderer& renderer);
-    void DrawPartition(MultipassRenderer& renderer, int partition, bool last_partition);
+    bool DrawPartition(MultipassRenderer& renderer, int partition);
+    bool FrameComplete(MultipassRenderer& renderer);
+    void AbandonFrame(MultipassRenderer& renderer);
+    const char* Name();
   private:
+    struct PlanStep {
+      // Clip plane depth if a pass starts here, and whether one may
+      numeric_types::fixed split;
+      bool can_split;
+      // Polygons in earlier passes that reach past split, and so are drawn
+      // again in a pass starting here
+      int overlap;
+      // Polygons in everything before here
+      int polycount;
+      // Best plan that ends a pass here: how many passes, how many polygons
+      // drawn in total, and where its last pass started
+      int passes;
+      int drawn;
+      int from;
+    };
+
+    struct Extent {
+      numeric_types::fixed near_z;
+      int cost;
+    };
+    // Heap order for important_
+    static bool FartherNearEdge(const Extent& a, const Extent& b);
+
     void GatherDrawList(MultipassRenderer& renderer);
+    void PlanPasses(MultipassRenderer& renderer);
+
+    FixedVector<PlanStep, MAX_ENTITIES + 1> plan_;
+    FixedVector<Extent, MAX_ENTITIES> important_;
+    // How many entities each pass of this frame takes from the draw list
+    FixedVector<int, MAX_ENTITIES> pass_sizes_;
+    unsigned int next_pass_{0};
 };
 
 } // namespace render
@@ -0,0 +1,88 @@
+#ifndef RENDER_FIXED_VECTOR_H
+#define RENDER_FIXED_VECTOR_H
+
+namespace render {
+
+// Just enough of std::vector for the renderer's lists, over storage that's
+// allocated once along with its owner. Nothing here touches the heap, so
+// filling and draining these every frame costs no more than the copies.
+//
+// Like the particle pool, anything pushed past the capacity is dropped;
+// push_back returns false when that happens, so callers can say so.
+template <typename T, int kCapacity>
+class FixedVector {
+  public:
+    bool push_back(const T& value) {
+      if (size_ >= (unsigned int)kCapacity) {
+        return false;
+      }
+      data_[size_++] = value;
+      return true;
+    }
+
+    void pop_back() {
+      size_--;
+    }
+
+    // Shifts everything after position down to fill the gap, keeping order
+    void erase(T* position) {
+      for (T* next = position + 1; next < end(); next++) {
+        *(next - 1) = *next;
+      }
+      size_--;
+    }
+
+    // Only ever grows into storage that's already there; anything past
+    // kCapacity is cut off
+    void resize(unsigned int size) {
+      size_ = size > (unsigned int)kCapacity ? kCapacity : size;
+    }
+
+    void clear() {
+      size_ = 0;
+    }
+
+    bool empty() const {
+      return size_ == 0;
+    }
+
+    unsigned int size() const {
+      return size_;
+    }
+
+    T& back() {
+      return data_[size_ - 1];
+    }
+
+    T& operator[](unsigned int index) {
+      return data_[index];
+    }
+
+    const T& operator[](unsigned int index) const {
+      return data_[index];
+    }
+
+    T* begin() {
+      return data_;
+    }
+
+    T* end() {
+      return data_ + size_;
+    }
+
+    const T* begin() const {
+      return data_;
+    }
+
+    const T* end() const {
+      return data_ + size_;
+    }
+
+  private:
+    T data_[kCapacity];
+    unsigned int size_{0};
+};
+
+}  // namespace render
+
+#endif
@@ -0,0 +1,78 @@
+#include "render/governor.h"
+
+#include "project_settings.h"
+
+using numeric_types::fixed;
+
+namespace render {
+
+// Each step gives up a little more than the last. Particles go first, as every
+// pass draws all of them; then pikmin in the distance, where a missing few are
+// hardest to notice.
+const Governor::Setting Governor::kLevels[] = {
+  {MAX_PARTICLES,     256, 0, 0},
+  {MAX_PARTICLES / 2, 256, 0, 1},
+  {MAX_PARTICLES / 2,  96, 1, 1},
+  {MAX_PARTICLES / 4,  64, 1, 2},
+  {MAX_PARTICLES / 8,  32, 3, 2},
+};
+const int Governor::kLevelCount = sizeof(kLevels) / sizeof(kLevels[0]);
+
+void Governor::FrameFinished(int passes, u32 slowest_pass_ticks,
+    bool dropped) {
+  bool over = dropped or passes > TARGET_PASSES_PER_FRAME or
+      slowest_pass_ticks > kVBlankTicks * 3 / 4;
+  frames_at_level_++;
+
+  if (recovering_ and frames_at_level_ >= frames_to_recover_) {
+    // The last step up held, so the next one needn't wait as long
+    recovering_ = false;
+    frames_to_recover_ = kFramesToRecover;
+  }
+
+  if (over) {
+    frames_under_ = 0;
+    frames_over_++;
+    if (frames_over_ >= kFramesToDrop and level_ < kLevelCount - 1) {
+      if (recovering_) {
+        frames_to_recover_ *= 2;
+        if (frames_to_recover_ > kMaxFramesToRecover) {
+          frames_to_recover_ = kMaxFramesToRecover;
+        }
+      }
+      level_++;
+      frames_over_ = 0;
+      frames_at_level_ = 0;
+      recovering_ = false;
+    }
+  } else {
+    frames_over_ = 0;
+    frames_under_++;
+    if (frames_under_ >= frames_to_recover_ and level_ > 0) {
+      level_--;
+      frames_under_ = 0;
+      frames_at_level_ = 0;
+      recovering_ = true;
+    }
+  }
+}
+
+int Governor::Level() {
+  return level_;
+}
+
+int Governor::ParticleBudget() {
+  return kLevels[level_].particle_budget;
+}
+
+int Governor::LodBias() {
+  return kLevels[level_].lod_bias;
+}
+
+bool Governor::ThinnedOut(bool important, fixed depth, unsigned int id) {
+  const Setting& setting = kLevels[level_];
+  return not important and (id & setting.thin_mask) != 0 and
+      depth > fixed::FromInt(setting.thin_depth);
+}
+
+}  // namespace render
@@ -0,0 +1,60 @@
+#ifndef RENDER_GOVERNOR_H
+#define RENDER_GOVERNOR_H
+
+#include <nds/ndstypes.h>
+
+#include "numeric_types.h"
+
+namespace render {
+
+// Holds the frame rate steady by trading detail for passes. After each frame
+// the renderer reports how many passes it took and how long the slowest one
+// spent drawing; frames that run long push the quality level down, and a long
+// enough run of frames that fit pulls it back up one step at a time.
+//
+// It drops quickly and recovers slowly. If a recovery doesn't hold, it waits
+// twice as long before trying again, so a scene that sits right on the edge
+// doesn't flicker between two levels.
+class Governor {
+  public:
+    void FrameFinished(int passes, u32 slowest_pass_ticks, bool dropped);
+
+    // 0 is full detail; higher levels draw less
+    int Level();
+    // Particles drawn each pass; any more are left out
+    int ParticleBudget();
+    // How many times to halve the distances where meshes step down in detail
+    int LodBias();
+    // Whether to leave this entity out of the frame: unimportant entities past
+    // a certain depth are thinned out, keeping one in every few. id should
+    // stay the same for an entity from frame to frame so the same ones vanish.
+    bool ThinnedOut(bool important, numeric_types::fixed depth, unsigned int id);
+
+  private:
+    struct Setting {
+      int particle_budget;
+      int thin_depth;
+      int thin_mask;
+      int lod_bias;
+    };
+    static const Setting kLevels[];
+    static const int kLevelCount;
+
+    // Bus clock ticks in one 60Hz frame; a pass that spends most of this just
+    // drawing entities is going to miss its vblank
+    static const u32 kVBlankTicks = 33513982 / 60;
+    static const int kFramesToDrop = 2;
+    static const int kFramesToRecover = 40;
+    static const int kMaxFramesToRecover = 640;
+
+    int level_{0};
+    int frames_over_{0};
+    int frames_under_{0};
+    int frames_at_level_{0};
+    int frames_to_recover_{kFramesToRecover};
+    bool recovering_{false};
+};
+
+}  // namespace render
+
+#endif
@@ -0,0 +1,197 @@
+#include "render/impostors.h"
+
+#include <vector>
+
+#include <nds/arm9/videoGL.h>
+
+#include "debug/messages.h"
+#include "dsgx.h"
+#include "dsgx_allocator.h"
+#include "project_settings.h"
+
+using numeric_types::literals::operator"" _f;
+using numeric_types::literals::operator"" _brad;
+using numeric_types::fixed;
+using numeric_types::Brads;
+
+namespace render {
+
+namespace {
+
+// The atlas is a 128 pixel wide direct color texture of 16 pixel cells, a row
+// of facings for each mesh, and only as tall as those rows need
+const int kAtlasWidth = 128;
+const int kCellSize = 16;
+const int kFacings = kAtlasWidth / kCellSize;
+const int kMaxRows = 8;
+
+// The camera looks down on the field at about this angle; sprites are drawn
+// from here, and the quads tilt to match wherever it really is
+const Brads kAtlasPitch = 30_brad;
+
+Impostor impostors_[kMaxRows];
+Brads view_yaw_;
+Brads view_pitch_;
+
+void WaitForVBlank() {
+  while (REG_VCOUNT != 192) {
+    continue;
+  }
+}
+
+// Draws one row of cells along the top of the screen, then captures it. The
+// mesh is drawn in whatever pose its display list holds; nothing here writes
+// to it.
+void CaptureRow(Mesh* mesh, u16* destination) {
+  glMatrixMode(GL_PROJECTION);
+  glLoadIdentity();
+  glOrtho(0.0f, 256.0f, 0.0f, 192.0f, -64.0f, 64.0f);
+  glMatrixMode(GL_MODELVIEW);
+  glPolyFmt(POLY_ALPHA(31) | POLY_CULL_BACK);
+
+  // Fit the bounding sphere to the cell
+  fixed scale = fixed::FromInt(kCellSize / 2) / mesh->bounding_radius;
+  for (int facing = 0; facing < kFacings; facing++) {
+    glLoadIdentity();
+    glTranslatef32(fixed::FromInt(facing * kCellSize + kCellSize / 2).data_,
+        fixed::FromInt(192 - kCellSize / 2).data_, 0);
+    glScalef32(scale.data_, scale.data_, scale.data_);
+    glRotateXi(kAtlasPitch.data_);
+    glRotateYi(facing * (32768 / kFacings));
+    glTranslatef32(-mesh->bounding_center.x.data_,
+        -mesh->bounding_center.y.data_, -mesh->bounding_center.z.data_);
+    glCallList(mesh->model_data);
+  }
+
+  // The new frame goes up at the next vblank, and the capture runs while it's
+  // shown, turning itself off when it's done
+  GFX_FLUSH = 0;
+  WaitForVBlank();
+  REG_DISPCAPCNT = DCAP_BANK(3) | DCAP_ENABLE | DCAP_SRC(1) | DCAP_SIZE(0);
+  while (REG_DISPCAPCNT & DCAP_ENABLE) {
+    continue;
+  }
+
+  for (int i = 0; i < kAtlasWidth * kCellSize; i++) {
+    destination[i] = VRAM_D[i];
+  }
+}
+
+}  // namespace
+
+void BuildImpostors(DsgxAllocator* actors, VramAllocator<Texture>* textures,
+    const ImpostorSource* sources, int count) {
+  vramSetBankD(VRAM_D_LCD);
+  // Leave everything outside the meshes with its alpha bit clear, so the
+  // captured texture is transparent there
+  glClearColor(0, 0, 0, 0);
+  glViewport(0, 0, 255, 191);
+
+  std::vector<u16> atlas(kAtlasWidth * kCellSize * kMaxRows, 0);
+  Mesh* meshes[kMaxRows];
+  int rows = 0;
+  for (int i = 0; i < count; i++) {
+    if (rows == kMaxRows) {
+      debug::Log("No room in the atlas for: " + std::string(sources[i].mesh));
+      continue;
+    }
+    Dsgx* actor = actors->Retrieve(sources[i].actor);
+    Mesh* mesh = actor ? actor->MeshByName(sources[i].mesh) : nullptr;
+    if (mesh == nullptr or mesh->model_data == nullptr) {
+      continue;
+    }
+    if ((int)mesh->draw_cost * kFacings > MAX_POLYGONS_PER_PASS) {
+      debug::Log("Too detailed for an impostor: " +
+          std::string(sources[i].mesh));
+      continue;
+    }
+
+    CaptureRow(mesh, &atlas[rows * kCellSize * kAtlasWidth]);
+    impostors_[rows].row = rows;
+    meshes[rows] = mesh;
+    rows++;
+  }
+  if (rows == 0) {
+    return;
+  }
+
+  // Textures come in powers of two, from 8 pixels up
+  int format_height = 1;
+  while ((8 << format_height) < rows * kCellSize) {
+    format_height++;
+  }
+  atlas.resize(kAtlasWidth * (8 << format_height));
+
+  // VRAM is only mapped to the CPU in LCD mode
+  vramSetBankC(VRAM_C_LCD);
+  Texture metadata;
+  metadata.format_width = 4;  // 128 pixels
+  metadata.format_height = format_height;
+  metadata.format = GL_RGBA;
+  metadata.transparency = Texture::kTransparent;
+  Texture texture = textures->Load("impostors", (u8*)atlas.data(),
+      atlas.size() * sizeof(u16), metadata);
+  vramSetBankC(VRAM_C_TEXTURE);
+  if (texture.offset == nullptr) {
+    return;
+  }
+
+  for (int i = 0; i < rows; i++) {
+    impostors_[i].texture = texture;
+    meshes[i]->impostor = &impostors_[i];
+  }
+}
+
+void SetImpostorView(Brads yaw, Brads pitch) {
+  view_yaw_ = yaw;
+  view_pitch_ = pitch;
+}
+
+int ImpostorCell(const Impostor& impostor, Brads facing) {
+  // Facing as the camera sees it, rounded to the nearest one in the atlas
+  const int kStep = 32768 / kFacings;
+  int column = (((facing + view_yaw_).data_ + kStep / 2) & 0x7FFF) / kStep;
+  return impostor.row * kFacings + column;
+}
+
+void DrawImpostor(const Impostor& impostor, int cell, Vec3 center,
+    fixed radius) {
+  glTranslatef32(center.x.data_, center.y.data_, center.z.data_);
+  // Undo the camera's turn, so the quad faces it
+  glRotateYi(-view_yaw_.data_);
+  glRotateXi(-view_pitch_.data_);
+  glScalef32(radius.data_, radius.data_, radius.data_);
+
+  // Set in full rather than relying on whatever the last entity drew with. The
+  // same format top to bottom passes start with, so nothing changes for the
+  // entities after this; fog only applies when the strategy turns it on.
+  glPolyFmt(POLY_ALPHA(31) | POLY_CULL_BACK | POLY_FOG);
+  glBegin(GL_QUAD);
+  // TEXIMAGE_PARAM, as DrawParticles sets it
+  *((u32*)0x40004A8) =
+    ((((u32)impostor.texture.offset) / 8) & 0xFFFF) |
+    (impostor.texture.format_width << 20) |
+    (impostor.texture.format_height << 23) |
+    (impostor.texture.format << 26);
+  glColor3b(255, 255, 255);
+
+  int left = (cell % kFacings) * kCellSize;
+  int top = (cell / kFacings) * kCellSize;
+  GFX_TEX_COORD = TEXTURE_PACK(inttot16(left), inttot16(top));
+  glVertex3v16(floattov16(-1.0), floattov16(1.0), 0);
+
+  GFX_TEX_COORD = TEXTURE_PACK(inttot16(left), inttot16(top + kCellSize));
+  glVertex3v16(floattov16(-1.0), floattov16(-1.0), 0);
+
+  GFX_TEX_COORD = TEXTURE_PACK(inttot16(left + kCellSize),
+      inttot16(top + kCellSize));
+  glVertex3v16(floattov16(1.0), floattov16(-1.0), 0);
+
+  GFX_TEX_COORD = TEXTURE_PACK(inttot16(left + kCellSize), inttot16(top));
+  glVertex3v16(floattov16(1.0), floattov16(1.0), 0);
+
+  // Turn off textures for the polygons after this
+  GFX_TEX_FORMAT = 0;
+}
+
+}  // namespace render
@@ -0,0 +1,53 @@
+#ifndef RENDER_IMPOSTORS_H
+#define RENDER_IMPOSTORS_H
+
+#include "numeric_types.h"
+#include "vram_allocator.h"
+#include "vector.h"
+
+class DsgxAllocator;
+
+namespace render {
+
+// Far away, a pikmin is a few pixels tall, and drawing its whole mesh is
+// wasted effort. Instead, a handful of meshes are rendered ahead of time into
+// a texture atlas, one small sprite for each facing, and past IMPOSTOR_DEPTH
+// they're drawn as a single textured quad that turns to face the camera.
+//
+// Sprites are taken from the mesh as it was loaded, so an animated mesh shows
+// its rest pose from that far out.
+struct Impostor {
+  // The atlas all impostors share
+  Texture texture;
+  // Atlas row of this mesh's facings, in cells
+  int row;
+};
+
+// A mesh to build an impostor for, named the way DsgxAllocator and
+// Dsgx::MeshByName know it
+struct ImpostorSource {
+  const char* actor;
+  const char* mesh;
+};
+
+// Renders the atlas through the display capture unit and hands each mesh in
+// sources its Impostor, up to one row of the atlas each. Takes a few frames,
+// so call it while loading, once the actors are in and before any are drawn.
+// It leaves the clear color transparent and bank D in LCD mode.
+void BuildImpostors(DsgxAllocator* actors, VramAllocator<Texture>* textures,
+    const ImpostorSource* sources, int count);
+
+// The rotation of the camera about Y, and how far it looks down, for picking
+// facings and turning quads toward it. Set once at the start of each frame.
+void SetImpostorView(numeric_types::Brads yaw, numeric_types::Brads pitch);
+
+// The atlas cell for a mesh turned to facing
+int ImpostorCell(const Impostor& impostor, numeric_types::Brads facing);
+
+// Draws one cell as a quad over the bounding sphere at center
+void DrawImpostor(const Impostor& impostor, int cell, Vec3 center,
+    numeric_types::fixed radius);
+
+}  // namespace render
+
+#endif
@@ -1,6 +1,7 @@
 #include "render/multipass_renderer.h"
 
 #include <stdio.h>
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -16,6 +17,7 @@
 #include "drawable.h"
 #include "project_settings.h"
 #include "particle.h"
+#include "render/impostors.h"
 
 using numeric_types::literals::operator"" _f;
 using numeric_types::fixed;
@@ -34,24 +36,55 @@ MultipassRenderer::MultipassRenderer() {
   tFrameInit =      debug::Profiler::RegisterTopic("Engine: Frame Init");
   tPassInit =       debug::Profiler::RegisterTopic("Engine: Pass Init");
   for (int i = 0; i < 5; i++) {
-    tPassUpdate[i] = debug::Profiler::RegisterTopic("Engine: Pass: " + std::to_string(i + 1));
+    tPassUpdate.push_back(debug::Profiler::RegisterTopic("Engine: Pass: " + std::to_string(i + 1)));
   }
   SetCamera(Vec3{0_f, 10_f, 0_f}, Vec3{64_f, 0_f, -62_f}, 45_brad);
+  previous_camera_position_ = current_camera_position_;
+  previous_camera_subject_ = current_camera_subject_;
   CacheCamera();
 
-  current_strategy_ = new render::BackToFront();
+  current_strategy_ = &back_to_front_;
+  next_strategy_ = current_strategy_;
 }
 
 void MultipassRenderer::EnableEffectsLayer(bool enabled) {
   effects_enabled = enabled;
 }
 
+void MultipassRenderer::UseTopToBottom(bool enabled) {
+  if (enabled) {
+    next_strategy_ = &top_to_bottom_;
+  } else {
+    next_strategy_ = &back_to_front_;
+  }
+}
+
+const char* MultipassRenderer::StrategyName() {
+  return current_strategy_->Name();
+}
+
+int MultipassRenderer::PassesLastFrame() {
+  return passes_last_frame_;
+}
+
+int MultipassRenderer::DroppedFrames() {
+  return dropped_frames_;
+}
+
+int MultipassRenderer::QualityLevel() {
+  return governor_.Level();
+}
+
 void MultipassRenderer::SetCamera(Vec3 position, Vec3 subject, Brads fov) {
   current_camera_position_ = position;
   current_camera_subject_ = subject;
   current_camera_fov_ = fov;
 }
 
+void MultipassRenderer::SetInterpolation(fixed alpha) {
+  interpolation_ = alpha;
+}
+
 void MultipassRenderer::PauseEngine() {
   paused_ = true;
   setBrightness(1, -10);
@@ -76,11 +109,23 @@ void MultipassRenderer::WaitForVBlank() {
 }
 
 void MultipassRenderer::AddEntity(Drawable* entity) {
-  entities_.push_back(entity);
+  if (!entities_.push_back(entity)) {
+    // It just won't be drawn; say so the first time, since it'll be missed
+    if (!warned_entity_limit_) {
+      debug::Log("Too many entities to draw; raise MAX_ENTITIES (" +
+          std::to_string(MAX_ENTITIES) + ")");
+      warned_entity_limit_ = true;
+    }
+    return;
+  }
+  entity->render_id = next_render_id_++;
 }
 
 void MultipassRenderer::RemoveEntity(Drawable* entity) {
-  entities_.remove(entity);
+  auto position = std::find(entities_.begin(), entities_.end(), entity);
+  if (position != entities_.end()) {
+    entities_.erase(position);
+  }
 }
 
 void MultipassRenderer::Update() {
@@ -88,6 +133,11 @@ void MultipassRenderer::Update() {
     return;
   }
 
+  // The camera moves with the simulation too, so it needs the same blending
+  // as everything it looks at
+  previous_camera_position_ = current_camera_position_;
+  previous_camera_subject_ = current_camera_subject_;
+
   debug::Profiler::StartTopic(tEntityUpdate);
   for (auto entity : entities_) {
     entity->Update();
@@ -99,7 +149,8 @@ void MultipassRenderer::Update() {
   debug::Profiler::EndTopic(tParticleUpdate);
 }
 
-void MultipassRenderer::ClipFriendlyPerspective(fixed near, fixed far, Brads angle) {
+void MultipassRenderer::ClipFriendlyPerspective(fixed near, fixed far, Brads angle,
+    int band_top, int band_bottom) {
   // Setup a projection matrix that, critically, does not scale Z-values. This
   // ensures that no matter how the near and far plane are set, the resulting
   // z-coordinate is not stretched or squashed, and is more or less accurate.
@@ -113,18 +164,29 @@ void MultipassRenderer::ClipFriendlyPerspective(fixed near, fixed far, Brads ang
   fixed cosine = trig::CosLerp(angle);
   //fixed cosine = trig::SinLerp(angle);
 
+  // To draw only a band of the screen, scale Y up so that the band fills clip
+  // space, and shift it (by way of W, which is -Z) so the band is centered.
+  // Only Y changes, so depth comes out the same whichever band is drawn.
+  fixed y_scale = cosine / sine;
+  fixed y_shift = 0_f;
+  if (band_top != 0 or band_bottom != 192) {
+    fixed band_height = fixed::FromInt(band_bottom - band_top);
+    y_scale = y_scale * (192_f / band_height);
+    y_shift = fixed::FromInt(192 - band_top - band_bottom) / band_height;
+  }
+
   MATRIX_LOAD4x4  = (((3_f * cosine) / (4_f * sine)).data_);
   MATRIX_LOAD4x4  = 0;
   MATRIX_LOAD4x4  = 0;
   MATRIX_LOAD4x4  = 0;
 
   MATRIX_LOAD4x4  = 0;
-  MATRIX_LOAD4x4  = (cosine / sine).data_;
+  MATRIX_LOAD4x4  = y_scale.data_;
   MATRIX_LOAD4x4  = 0;
   MATRIX_LOAD4x4  = 0;
 
   MATRIX_LOAD4x4  = 0;
-  MATRIX_LOAD4x4  = 0;
+  MATRIX_LOAD4x4  = y_shift.data_;
   MATRIX_LOAD4x4  = -((far + near) / (far - near)).data_;
   MATRIX_LOAD4x4  = (-1.0_f).data_;
 
@@ -136,9 +198,89 @@ void MultipassRenderer::ClipFriendlyPerspective(fixed near, fixed far, Brads ang
 }
 
 void MultipassRenderer::CacheCamera() {
-  cached_camera_position_ = current_camera_position_;
-  cached_camera_subject_ = current_camera_subject_;
+  cached_camera_position_ = previous_camera_position_ +
+      (current_camera_position_ - previous_camera_position_) * interpolation_;
+  cached_camera_subject_ = previous_camera_subject_ +
+      (current_camera_subject_ - previous_camera_subject_) * interpolation_;
   cached_camera_fov_ = current_camera_fov_;
+
+  view_forward_ = (cached_camera_subject_ - cached_camera_position_).Normalize();
+  view_across_ = Vec3{-view_forward_.z, 0_f, view_forward_.x}.Normalize();
+  view_up_ = Vec3{
+      -view_across_.z * view_forward_.y,
+      view_across_.z * view_forward_.x - view_across_.x * view_forward_.z,
+      view_across_.x * view_forward_.y};
+
+  // Matches ClipFriendlyPerspective
+  fixed sine = trig::SinLerp(cached_camera_fov_);
+  fixed cosine = trig::CosLerp(cached_camera_fov_);
+  x_slope_ = (3_f * cosine) / (4_f * sine);
+  y_slope_ = cosine / sine;
+  x_slope_norm_ = Vec2{x_slope_, 1_f}.Length();
+  y_slope_norm_ = Vec2{y_slope_, 1_f}.Length();
+
+  // The turn about Y that brings the view to face down -Z, as glRotateYi
+  // measures it, and how far the view tips down after that
+  render::SetImpostorView(trig::Atan2(view_forward_.x, -view_forward_.z),
+      trig::Atan2(-view_forward_.y,
+          Vec2{view_forward_.x, view_forward_.z}.Length()));
+}
+
+void MultipassRenderer::CullEntities() {
+  // Only big entities that straddle the edge of the view are worth a hardware
+  // test. The sphere tests are loose near the frustum's corners, and for
+  // small ones that costs less than waiting on the geometry engine.
+  const fixed kLargeRadius = 8_f;
+
+  // Set up the full view for those hardware tests
+  ClipFriendlyPerspective(0.1_f, 256.0_f, cached_camera_fov_);
+  glLoadIdentity();
+  ApplyCameraTransform();
+
+  visible_.clear();
+  for (auto entity : entities_) {
+    // Cache the object so its render information stays the same across
+    // multiple passes.
+    entity->SetCache(interpolation_);
+    entity->overlaps = 0;
+
+    Vec3 offset = entity->BoundingCenter() - cached_camera_position_;
+    EntityView view;
+    view.entity = entity;
+    view.depth = offset.x * view_forward_.x + offset.y * view_forward_.y +
+        offset.z * view_forward_.z;
+    view.height = offset.x * view_up_.x + offset.y * view_up_.y +
+        offset.z * view_up_.z;
+    view.radius = entity->BoundingRadius();
+    fixed across = offset.x * view_across_.x + offset.z * view_across_.z;
+
+    // How far the center is past each pair of frustum planes, scaled so they
+    // compare against the radius; negative is inside
+    fixed past_sides = (across < 0_f ? -across : across) * x_slope_ -
+        view.depth;
+    fixed past_top = (view.height < 0_f ? -view.height : view.height) *
+        y_slope_ - view.depth;
+    fixed x_reach = view.radius * x_slope_norm_;
+    fixed y_reach = view.radius * y_slope_norm_;
+
+    bool visible = view.depth + view.radius > 0.1_f and
+        view.depth - view.radius < 256_f and
+        past_sides < x_reach and past_top < y_reach;
+    if (visible and view.radius > kLargeRadius) {
+      bool straddles = view.depth - view.radius < 0.1_f or
+          view.depth + view.radius > 256_f or
+          past_sides > -x_reach or past_top > -y_reach;
+      if (straddles) {
+        visible = entity->InsideViewFrustrum();
+      }
+    }
+
+    entity->visible = visible;
+    if (visible) {
+      entity->ChooseDetail(view.depth, governor_.LodBias());
+      visible_.push_back(view);
+    }
+  }
 }
 
 void MultipassRenderer::ApplyCameraTransform() {
@@ -151,15 +293,11 @@ void MultipassRenderer::ApplyCameraTransform() {
 
 void MultipassRenderer::ClearDrawList() {
   // Clear the draw list so that the next frame gets triggered.
-  // It is emptied by looping because std::priority_queue does not provide
-  // a clear function.
-  while (not draw_list_.empty()) {
-    draw_list_.pop();
-  }
+  draw_list_.clear();
 }
 
 bool MultipassRenderer::LastPass() {
-  return draw_list_.empty() and (effects_drawn or !effects_enabled);
+  return current_strategy_->FrameComplete(*this) and (effects_drawn or !effects_enabled);
 }
 
 void MultipassRenderer::SetVRAMforPass(int pass) {
@@ -248,8 +386,20 @@ void MultipassRenderer::DrawClearPlane() {
 }
 
 void MultipassRenderer::InitializeRender() {
+  // Let the governor know how the last frame went, before its timings are
+  // cleared
+  u32 slowest_pass = 0;
+  for (int i = 0; i < current_pass_ and i < (int)tPassUpdate.size(); i++) {
+    u32 pass_time = debug::Profiler::Topics()[tPassUpdate[i]].timing.delta();
+    if (pass_time > slowest_pass) {
+      slowest_pass = pass_time;
+    }
+  }
+  governor_.FrameFinished(current_pass_, slowest_pass, frame_dropped_);
+  frame_dropped_ = false;
+
   // Initialize the debug counts for this pass
-  for (int i = current_pass_; i < 5; i++) {
+  for (int i = current_pass_; i < (int)tPassUpdate.size(); i++) {
     debug::Profiler::ClearTopic(tPassUpdate[i]);
   }
 
@@ -267,16 +417,101 @@ void MultipassRenderer::InitializeRender() {
   // Ensure the overlap list is empty.
   overlap_list_.clear();
 
+  // Switch strategies between frames, never partway through one
+  if (next_strategy_ != current_strategy_) {
+    current_strategy_ = next_strategy_;
+    dropped_frames_ = 0;
+    if (current_strategy_->SupportsFog()) {
+      glEnable(GL_FOG);
+    } else {
+      glDisable(GL_FOG);
+    }
+  }
+
+  passes_last_frame_ = current_pass_;
   current_pass_ = 0;
   effects_drawn = false;
 
+  CullEntities();
   current_strategy_->InitializeRender(*this);
   effects_enabled = debug::Flag("Draw Effects Layer");
 
   debug::Profiler::EndTopic(tFrameInit);
 }
 
-void MultipassRenderer::GatherPassList() {
+void MultipassRenderer::SortDrawList() {
+  // The draw list was gathered in last frame's order, and depth order barely
+  // changes between frames, so an insertion sort usually only has a few
+  // entities to nudge. If it ends up moving a lot of them, the camera probably
+  // cut or spun round, so give up and radix sort the lot instead.
+  const int count = draw_list_.size();
+  int moves_left = count * 4;
+  for (int i = 1; i < count and moves_left >= 0; i++) {
+    EntityContainer container = draw_list_[i];
+    int j = i;
+    while (j > 0 and container < draw_list_[j - 1]) {
+      draw_list_[j] = draw_list_[j - 1];
+      j--;
+      moves_left--;
+    }
+    draw_list_[j] = container;
+  }
+  if (moves_left < 0) {
+    RadixSortDrawList();
+  }
+
+  // Put entities_ in the same order for next frame, followed by everything
+  // that wasn't drawn, still in the order it was in
+  int hidden = 0;
+  for (auto entity : entities_) {
+    if (not entity->visible) {
+      entities_[hidden++] = entity;
+    }
+  }
+  int drawn = entities_.size() - hidden;
+  for (int i = hidden - 1; i >= 0; i--) {
+    entities_[drawn + i] = entities_[i];
+  }
+  for (int i = 0; i < drawn and i < count; i++) {
+    entities_[i] = draw_list_[i].entity;
+  }
+}
+
+void MultipassRenderer::RadixSortDrawList() {
+  // Sort on far_z a byte at a time, lowest first. Flipping the sign bit makes
+  // the raw fixed point values sort correctly as unsigned.
+  const int count = draw_list_.size();
+  sort_scratch_.resize(count);
+  EntityContainer* from = draw_list_.begin();
+  EntityContainer* to = sort_scratch_.begin();
+  for (int shift = 0; shift < 32; shift += 8) {
+    int offsets[256] = {0};
+    for (int i = 0; i < count; i++) {
+      offsets[(((u32)from[i].far_z.data_ ^ 0x80000000) >> shift) & 0xFF]++;
+    }
+    // Every key has the same byte here, so this pass wouldn't move anything
+    if (offsets[(((u32)from[0].far_z.data_ ^ 0x80000000) >> shift) & 0xFF] ==
+        count) {
+      continue;
+    }
+    int total = 0;
+    for (int bucket = 0; bucket < 256; bucket++) {
+      int size = offsets[bucket];
+      offsets[bucket] = total;
+      total += size;
+    }
+    for (int i = 0; i < count; i++) {
+      to[offsets[(((u32)from[i].far_z.data_ ^ 0x80000000) >> shift) & 0xFF]++] =
+          from[i];
+    }
+    std::swap(from, to);
+  }
+  if (from != draw_list_.begin()) {
+    std::copy(from, from + count, draw_list_.begin());
+  }
+}
+
+void MultipassRenderer::GatherPassList(unsigned int count) {
   debug::Profiler::StartTopic(tPassInit);
 
   // Build up the list of objects to render this pass.
@@ -288,7 +523,7 @@ void MultipassRenderer::GatherPassList() {
   // int overlaps_count = overlap_list_.size();
   for (auto entity : overlap_list_) {
     pass_list_.push_back(entity);
-    polycount += pass_list_.back().entity->GetCachedState().current_mesh->draw_cost;
+    polycount += pass_list_.back().entity->DrawCost();
   }
   if (polycount >= MAX_POLYGONS_PER_PASS) {
     // attempt to recover here; *drop* the overlap list, and rebuild it only
@@ -300,22 +535,18 @@ void MultipassRenderer::GatherPassList() {
     for (auto entity : overlap_list_) {
       if (entity.entity->important) {
         pass_list_.push_back(entity);
-        polycount += pass_list_.back().entity->GetCachedState().current_mesh->draw_cost;
+        polycount += pass_list_.back().entity->DrawCost();
       }
     }
   }
   overlap_list_.clear();
 
-  int objects_this_pass = 0;
-
-  // Pull entities from the list of all entities to draw this frame until all
-  // objects are marked for drawing (marking a complete frame) or the polygon
-  // quota is hit, whichever comes first.
-  while (not draw_list_.empty() and polycount < MAX_POLYGONS_PER_PASS and objects_this_pass < MAX_OBJECTS_PER_PASS) {
-    pass_list_.push_back(draw_list_.top());
-    polycount += pass_list_.back().entity->GetCachedState().current_mesh->draw_cost;
-    draw_list_.pop();
-    objects_this_pass++;
+  // Pull however many entities the strategy planned for this pass from the
+  // list of all entities to draw this frame.
+  while (not draw_list_.empty() and count > 0) {
+    pass_list_.push_back(draw_list_.back());
+    draw_list_.pop_back();
+    count--;
   }
 
   debug::Profiler::EndTopic(tPassInit);
@@ -334,7 +565,9 @@ bool MultipassRenderer::ProgressMadeThisPass(unsigned int initial_length) {
 }
 
 void MultipassRenderer::BailAndResetFrame() {
-  ClearDrawList();
+  current_strategy_->AbandonFrame(*this);
+  dropped_frames_++;
+  frame_dropped_ = true;
 
   GFX_FLUSH = 0;
   WaitForVBlank();
@@ -354,7 +587,7 @@ void MultipassRenderer::SetupDividingPlane() {
   }
   near_plane_ = 0.1_f;
   if (not draw_list_.empty()) {
-    near_plane_ = draw_list_.top().far_z;
+    near_plane_ = draw_list_.back().far_z;
     // If that entity is too close to or behind the camera, then clamp the near
     // plane to just in front of the camera.
     if (near_plane_ < 0.1_f) {
@@ -405,7 +638,7 @@ bool MultipassRenderer::ValidateDividingPlane() {
 
 void MultipassRenderer::DrawPassList() {
   // Draw the entities for the pass.
-  if (current_pass_ < 9) {
+  if (current_pass_ < (int)tPassUpdate.size()) {
     debug::Profiler::StartTopic(tPassUpdate[current_pass_]);
   }
 
@@ -421,7 +654,7 @@ void MultipassRenderer::DrawPassList() {
       overlap_list_.push_back(container);
     }
   }
-  if (current_pass_ < 9) {
+  if (current_pass_ < (int)tPassUpdate.size()) {
     debug::Profiler::EndTopic(tPassUpdate[current_pass_]);
   }
 }
@@ -439,31 +672,22 @@ void MultipassRenderer::Draw() {
     InitializeRender();
   }
 
-  if (draw_list_.empty() and effects_enabled) {
+  if (current_strategy_->FrameComplete(*this) and effects_enabled) {
     DrawEffects();
   } else {
-    unsigned int initial_length = draw_list_.size();
-    GatherPassList();
-
-    if (not ProgressMadeThisPass(initial_length)) {
-      BailAndResetFrame();
-      return;
-    }
-
-    SetupDividingPlane();
-
-    if (not ValidateDividingPlane()) {
+    if (not current_strategy_->DrawPartition(*this, current_pass_)) {
       return;
     }
 
-    DrawPassList();
-
     debug::Profiler::StartTopic(tParticleDraw);
-    DrawParticles(cached_camera_position_, cached_camera_subject_);
+    DrawParticles(cached_camera_position_, cached_camera_subject_,
+        governor_.ParticleBudget());
     debug::Profiler::EndTopic(tParticleDraw);
 
-    // Reset the polygon format after all that drawing
+    // Reset the polygon format and viewport after all that drawing; the rear
+    // plane always covers the whole screen
     glPolyFmt(POLY_ALPHA(31) | POLY_CULL_BACK);
+    glViewport(0, 0, 255, 191);
   }
 
   DrawClearPlane();
@@ -474,8 +698,8 @@ void MultipassRenderer::Draw() {
   WaitForVBlank();
 
   if (debug::Flag("Render First Pass Only")) {
-    // Empty the draw list; limiting the frame to one pass.
-    ClearDrawList();
+    // Drop the rest of the frame; limiting it to one pass.
+    current_strategy_->AbandonFrame(*this);
   }
 
   SetVRAMforPass(current_pass_);
@@ -1,13 +1,16 @@
 #ifndef MULTIPASS_RENDERER_H
 #define MULTIPASS_RENDERER_H
 
-#include <list>
-#include <queue>
+#include <vector>
 
 #include "debug/profiler.h"
 #include "render/strategy.h"
 #include "render/back_to_front.h"
+#include "render/fixed_vector.h"
+#include "render/governor.h"
+#include "render/top_to_bottom.h"
 #include "numeric_types.h"
+#include "project_settings.h"
 #include "vector.h"
 
 class Drawable;
@@ -22,6 +25,17 @@ struct EntityContainer {
   }
 };
 
+// Where an entity's bounding sphere sits in front of the camera, from the
+// culling pass at the start of each frame
+struct EntityView {
+  Drawable* entity;
+  // Camera space position of the sphere's center: distance along the view,
+  // and height above its middle
+  numeric_types::fixed depth;
+  numeric_types::fixed height;
+  numeric_types::fixed radius;
+};
+
 class MultipassRenderer {
  public:
   MultipassRenderer();
@@ -38,12 +52,26 @@ class MultipassRenderer {
 
   void SetCamera(Vec3 position, Vec3 subject, numeric_types::Brads fov);
 
+  // How far (0 to 1) the display is between the last two simulation steps,
+  // as of the next frame to begin.
+  void SetInterpolation(numeric_types::fixed alpha);
+
   void EnableEffectsLayer(bool enabled);
   void DebugCircles();
 
+  // Switches how frames are partitioned, starting with the next frame
+  void UseTopToBottom(bool enabled);
+  const char* StrategyName();
+  int PassesLastFrame();
+  // Frames given up on since the last strategy switch
+  int DroppedFrames();
+  // How much detail the governor is holding back; 0 is none
+  int QualityLevel();
+
  private:
   friend class render::Strategy;
   friend class render::BackToFront;
+  friend class render::TopToBottom;
   void InitializeRender();
 
   void ClearDrawList();
@@ -54,7 +82,17 @@ class MultipassRenderer {
   void CacheCamera();
   void ApplyCameraTransform();
 
-  void GatherPassList();
+  // Tests every entity's bounding sphere against the view on the CPU, and
+  // gathers the ones that can be seen into visible_
+  void CullEntities();
+
+  // Sorts the draw list nearest first, then puts entities_ in that order to
+  // give the next frame's sort a head start
+  void SortDrawList();
+  void RadixSortDrawList();
+
+  // Takes the next count entities off the draw list, plus last pass's overlaps
+  void GatherPassList(unsigned int count);
   bool ProgressMadeThisPass(unsigned int initial_length);
   void SetupDividingPlane();
   bool ValidateDividingPlane();
@@ -64,18 +102,35 @@ class MultipassRenderer {
 
   void WaitForVBlank();
 
-  void ClipFriendlyPerspective(numeric_types::fixed near, numeric_types::fixed far, numeric_types::Brads angle);
+  // band_top and band_bottom pick out a range of screen rows to stretch over
+  // the whole projection, for drawing with a matching viewport
+  void ClipFriendlyPerspective(numeric_types::fixed near, numeric_types::fixed far, numeric_types::Brads angle,
+      int band_top = 0, int band_bottom = 192);
 
+  render::BackToFront back_to_front_;
+  render::TopToBottom top_to_bottom_;
   render::Strategy* current_strategy_;
+  render::Strategy* next_strategy_;
+  render::Governor governor_;
   bool paused_ = false;
 
-  std::list<Drawable*> entities_;
+  // Every entity, in the order the last frame drew them (nearest first), with
+  // anything it didn't draw after that
+  render::FixedVector<Drawable*, MAX_ENTITIES> entities_;
+  unsigned int next_render_id_{0};
+  bool warned_entity_limit_{false};
 
-  std::priority_queue<EntityContainer> draw_list_;
-  std::vector<EntityContainer> overlap_list_;
-  std::vector<EntityContainer> pass_list_;
+  // Sorted nearest first, so the next entity to draw is at the back
+  render::FixedVector<EntityContainer, MAX_ENTITIES> draw_list_;
+  render::FixedVector<EntityContainer, MAX_ENTITIES> overlap_list_;
+  render::FixedVector<EntityContainer, MAX_ENTITIES> pass_list_;
+  render::FixedVector<EntityContainer, MAX_ENTITIES> sort_scratch_;
+  render::FixedVector<EntityView, MAX_ENTITIES> visible_;
 
   int current_pass_{0};
+  int passes_last_frame_{0};
+  int dropped_frames_{0};
+  bool frame_dropped_{false};
 
   numeric_types::fixed near_plane_;
   numeric_types::fixed far_plane_;
@@ -84,10 +139,26 @@ class MultipassRenderer {
   Vec3 current_camera_subject_;
   numeric_types::Brads current_camera_fov_;
 
+  Vec3 previous_camera_position_;
+  Vec3 previous_camera_subject_;
+  numeric_types::fixed interpolation_{numeric_types::fixed::FromInt(1)};
+
   Vec3 cached_camera_position_;
   Vec3 cached_camera_subject_;
   numeric_types::Brads cached_camera_fov_;
 
+  // The cached camera's axes, as gluLookAt works them out, and the slopes of
+  // the sides of the full screen frustum: an entity is in view while
+  // |across| * x_slope and |height| * y_slope are under its depth. The norms
+  // turn a distance past those edges into a distance past the frustum planes.
+  Vec3 view_across_;
+  Vec3 view_up_;
+  Vec3 view_forward_;
+  numeric_types::fixed x_slope_;
+  numeric_types::fixed y_slope_;
+  numeric_types::fixed x_slope_norm_;
+  numeric_types::fixed y_slope_norm_;
+
   unsigned int frame_counter_{0};
 
   bool effects_enabled{false};
@@ -5,10 +5,23 @@ class MultipassRenderer;
 
 namespace render {
 
+// Decides how a frame is split up into passes. InitializeRender is called at
+// the start of every frame, then DrawPartition once per pass until
+// FrameComplete returns true.
 class Strategy {
   public:
+    virtual ~Strategy() {}
     virtual void InitializeRender(MultipassRenderer& renderer) = 0;
-    virtual void DrawPartition(MultipassRenderer& renderer, int partition, bool last_partition) = 0;
+    // Sets up the matrices for this pass and draws everything in it. Returns
+    // false if the frame had to be given up, in which case the pass has
+    // already been dealt with and nothing else should be drawn.
+    virtual bool DrawPartition(MultipassRenderer& renderer, int partition) = 0;
+    virtual bool FrameComplete(MultipassRenderer& renderer) = 0;
+    // Drops whatever is left of the current frame
+    virtual void AbandonFrame(MultipassRenderer& renderer) = 0;
+    // Whether every pass keeps the same depth values, which fog relies on
+    virtual bool SupportsFog() { return false; }
+    virtual const char* Name() = 0;
 };
 
 } // namespace render
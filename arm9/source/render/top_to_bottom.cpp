@@ -0,0 +1,164 @@
+#include "render/top_to_bottom.h"
+
+#include "render/multipass_renderer.h"
+#include "drawable.h"
+#include "numeric_types.h"
+#include "project_settings.h"
+
+using numeric_types::literals::operator"" _f;
+using numeric_types::fixed;
+
+namespace render {
+
+void TopToBottom::GatherDrawList(MultipassRenderer& renderer) {
+  // Screen position runs from -1 at the bottom to 1 at the top
+  auto strip_at = [](fixed screen_y) {
+    if (screen_y > 1_f) {
+      screen_y = 1_f;
+    }
+    if (screen_y < -1_f) {
+      screen_y = -1_f;
+    }
+    int row = (int)((1_f - screen_y) * fixed::FromInt(kScreenRows / 2));
+    if (row > kScreenRows - 1) {
+      row = kScreenRows - 1;
+    }
+    return row / kStripHeight;
+  };
+
+  entries_.clear();
+  for (auto& view : renderer.visible_) {
+    Drawable* entity = view.entity;
+    if (renderer.governor_.ThinnedOut(entity->important, view.depth,
+        entity->render_id)) {
+      entity->visible = false;
+      continue;
+    }
+
+    // Where the center lands in clip space; W is just the depth
+    fixed y = view.height * renderer.y_slope_;
+    fixed w = view.depth;
+
+    // Project the top and bottom of the bounding sphere, each from whichever
+    // side of it puts that edge further from the middle of the screen. A
+    // sphere that reaches the camera could be anywhere, so it gets every band.
+    fixed radius = view.radius;
+    fixed near_w = w - radius;
+    fixed far_w = w + radius;
+    int first_strip = 0;
+    int last_strip = kStrips - 1;
+    if (near_w > 0.1_f) {
+      fixed top = y + radius * renderer.y_slope_;
+      fixed bottom = y - radius * renderer.y_slope_;
+      first_strip = strip_at(top / (top > 0_f ? near_w : far_w));
+      last_strip = strip_at(bottom / (bottom < 0_f ? near_w : far_w));
+    }
+
+    entries_.push_back(Entry{entity, (int)entity->DrawCost(),
+        (u8)first_strip, (u8)last_strip});
+  }
+}
+
+void TopToBottom::InitializeRender(MultipassRenderer& renderer) {
+  GatherDrawList(renderer);
+  next_strip_ = 0;
+}
+
+bool TopToBottom::DrawPartition(MultipassRenderer& renderer, int partition) {
+  debug::Profiler::StartTopic(renderer.tPassInit);
+
+  // Start with everything touching the first strip, then take in strips below
+  // it for as long as the entities starting in them still fit
+  int top = next_strip_;
+  int polycount = 0;
+  int objects = 0;
+  for (auto& entry : entries_) {
+    if (entry.first_strip <= top and entry.last_strip >= top) {
+      polycount += entry.cost;
+      objects++;
+    }
+  }
+  int bottom = top;
+  while (bottom + 1 < kStrips) {
+    int strip_polycount = 0;
+    int strip_objects = 0;
+    for (auto& entry : entries_) {
+      if (entry.first_strip == bottom + 1) {
+        strip_polycount += entry.cost;
+        strip_objects++;
+      }
+    }
+    if (polycount + strip_polycount > MAX_POLYGONS_PER_PASS or
+        objects + strip_objects > MAX_OBJECTS_PER_PASS) {
+      break;
+    }
+    polycount += strip_polycount;
+    objects += strip_objects;
+    bottom++;
+  }
+  next_strip_ = bottom + 1;
+
+  // A single strip can still be over budget on its own. As BackToFront does
+  // with its overlaps, keep only the important entities in that case, and
+  // let the rest flicker.
+  bool only_important = polycount > MAX_POLYGONS_PER_PASS;
+  renderer.pass_list_.clear();
+  for (auto& entry : entries_) {
+    if (entry.first_strip > bottom or entry.last_strip < top) {
+      continue;
+    }
+    if (only_important and not entry.entity->important) {
+      continue;
+    }
+    EntityContainer container;
+    container.entity = entry.entity;
+    renderer.pass_list_.push_back(container);
+    if (entry.first_strip < top) {
+      // Already drawn in a band above this one
+      entry.entity->overlaps++;
+    }
+  }
+
+  debug::Profiler::EndTopic(renderer.tPassInit);
+
+  int band_top = top * kStripHeight;
+  int band_bottom = (bottom + 1) * kStripHeight;
+  renderer.ClipFriendlyPerspective(0.1_f, 256.0_f, renderer.cached_camera_fov_,
+      band_top, band_bottom);
+  // The viewport counts up from the bottom of the screen
+  glViewport(0, kScreenRows - band_bottom, 255, kScreenRows - 1 - band_top);
+  glLoadIdentity();
+  renderer.ApplyCameraTransform();
+
+  if (partition < (int)renderer.tPassUpdate.size()) {
+    debug::Profiler::StartTopic(renderer.tPassUpdate[partition]);
+  }
+  glPolyFmt(POLY_ALPHA(31) | POLY_CULL_BACK | POLY_FOG);
+  for (auto& container : renderer.pass_list_) {
+    glPushMatrix();
+    container.entity->Draw();
+    glPopMatrix(1);
+  }
+  if (partition < (int)renderer.tPassUpdate.size()) {
+    debug::Profiler::EndTopic(renderer.tPassUpdate[partition]);
+  }
+  return true;
+}
+
+bool TopToBottom::FrameComplete(MultipassRenderer& renderer) {
+  return next_strip_ >= kStrips;
+}
+
+void TopToBottom::AbandonFrame(MultipassRenderer& renderer) {
+  next_strip_ = kStrips;
+}
+
+bool TopToBottom::SupportsFog() {
+  return true;
+}
+
+const char* TopToBottom::Name() {
+  return "Top to Bottom";
+}
+
+} // namespace render
@@ -0,0 +1,51 @@
+#ifndef RENDER_TOP_TO_BOTTOM_H
+#define RENDER_TOP_TO_BOTTOM_H
+
+#include <nds/ndstypes.h>
+
+#include "project_settings.h"
+#include "render/fixed_vector.h"
+#include "render/strategy.h"
+
+class Drawable;
+
+namespace render {
+
+// Splits the screen into horizontal bands and draws one band per pass, from
+// the top down. Each pass stretches its band over the whole projection and
+// narrows the viewport to match, so the hardware clips everything else away
+// and draws every entity that touches the band. Depth is never touched, so
+// unlike BackToFront, fog and translucency come out right.
+//
+// Bands are made of strips a few rows tall, and each one grows downward
+// until the next strip would put it over the polygon budget.
+class TopToBottom : public Strategy {
+  public:
+    void InitializeRender(MultipassRenderer& renderer);
+    bool DrawPartition(MultipassRenderer& renderer, int partition);
+    bool FrameComplete(MultipassRenderer& renderer);
+    void AbandonFrame(MultipassRenderer& renderer);
+    bool SupportsFog();
+    const char* Name();
+
+  private:
+    static const int kScreenRows = 192;
+    static const int kStripHeight = 8;
+    static const int kStrips = kScreenRows / kStripHeight;
+
+    struct Entry {
+      Drawable* entity;
+      int cost;
+      u8 first_strip;
+      u8 last_strip;
+    };
+
+    void GatherDrawList(MultipassRenderer& renderer);
+
+    FixedVector<Entry, MAX_ENTITIES> entries_;
+    int next_strip_{kStrips};
+};
+
+} // namespace render
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef TCM_H
+#define TCM_H
+
+#include <nds/ndstypes.h>
+
+// Placement for the few things hot enough to deserve the ARM9's tightly
+// coupled memories. Both are tiny and shared with libnds, so check the usage
+// report printed after linking before adding to either list.
+//
+// HOT_CODE: compiled as ARM rather than Thumb (needs GCC 6 or newer) and
+// linked into ITCM (32KB, no wait states, never evicted). Put it on the
+// declaration so callers use a long call; it does nothing for functions that
+// end up inlined.
+//
+// HOT_DATA / HOT_BSS: initialized / zeroed data in DTCM (16KB, which the
+// stack grows down into from the top). Only useful for file-scope objects.
+//
+// Build with TCM=0 to compile all of these away for A/B profiling.
+#if defined(ARM9) && !defined(DISABLE_TCM)
+#define HOT_CODE ITCM_CODE __attribute__((target("arm")))
+#define HOT_DATA DTCM_DATA
+#define HOT_BSS DTCM_BSS
+#else
+#define HOT_CODE
+#define HOT_DATA
+#define HOT_BSS
+#endif
+
+#endif  // TCM_H
@@ -0,0 +1,73 @@
+#include "trig.h"
+
+using numeric_types::Brads;
+using numeric_types::fixed;
+
+namespace trig {
+
+namespace {
+
+// atan(2^-i) in sixteenths of a brad (2^19 to the circle); the extra bits
+// keep the rounding of each step from adding up
+const s32 kAtanSteps[] = {
+  65536, 38688, 20442, 10377, 5208, 2607, 1304, 652, 326, 163, 81, 41, 20, 10,
+};
+const int kIterations = sizeof(kAtanSteps) / sizeof(kAtanSteps[0]);
+
+}  // namespace
+
+Brads Atan2(fixed y, fixed x) {
+  s32 vx = x.data_;
+  s32 vy = y.data_;
+  u32 magnitude = (u32)(vx < 0 ? -vx : vx) | (u32)(vy < 0 ? -vy : vy);
+  if (magnitude == 0) {
+    return Brads::Raw(0);
+  }
+
+  // Only the direction matters, so scale the vector until its largest
+  // component sits just below 2^28. That keeps precision for short vectors
+  // and leaves room for CORDIC's gain of ~1.65 on long ones.
+  int shift = __builtin_clz(magnitude) - 4;
+  if (shift > 0) {
+    vx <<= shift;
+    vy <<= shift;
+  } else {
+    vx >>= -shift;
+    vy >>= -shift;
+  }
+
+  // CORDIC only converges within 90 degrees of the X axis, so rotate the
+  // left half plane over first
+  s32 angle = 0;
+  if (vx < 0) {
+    s32 old_x = vx;
+    if (vy >= 0) {
+      vx = vy;
+      vy = -old_x;
+      angle = 8192 << 4;
+    } else {
+      vx = -vy;
+      vy = old_x;
+      angle = -8192 << 4;
+    }
+  }
+
+  // Rotate toward the X axis by ever smaller steps, adding up how far it went
+  for (int i = 0; i < kIterations; i++) {
+    s32 step_x = vy >> i;
+    s32 step_y = vx >> i;
+    if (vy > 0) {
+      vx += step_x;
+      vy -= step_y;
+      angle += kAtanSteps[i];
+    } else {
+      vx -= step_x;
+      vy += step_y;
+      angle -= kAtanSteps[i];
+    }
+  }
+
+  return Brads::Raw((s16)((angle + 8) >> 4));
+}
+
+}  // namespace trig
@@ -4,6 +4,7 @@
 #include <nds.h>
 
 #include "numeric_types.h"
+#include "tcm.h"
 
 namespace trig {
 
@@ -27,6 +28,13 @@ static inline numeric_types::fixed ACosLerp(numeric_types::Brads angle)  {
   return numeric_types::fixed::FromRaw(acosLerp(angle.data_));
 }
 
+// The angle from the X axis toward (x, y), counterclockwise, like atan2 from
+// the standard library. The vector doesn't need to be normalized, and only
+// shifts and adds are used, so this is safe to call while the divide or
+// square root units are busy. Accurate to about a brad.
+HOT_CODE numeric_types::Brads Atan2(numeric_types::fixed y,
+    numeric_types::fixed x);
+
 }  // namespace trig
 
 #endif
@@ -7,6 +7,7 @@
 #include "ai/captain.h"
 #include "debug/profiler.h"
 #include "debug/utilities.h"
+#include "input_utils.h"
 #include "pikmin_game.h"
 #include "wide_console.h"
 
@@ -231,7 +232,7 @@ void UpdateNavPad(UIState& ui) {
 }
 
 bool OpenOnionUI(const UIState& ui) {
-  if (keysDown() & KEY_A) {
+  if (input::Down() & KEY_A) {
     auto captain = ui.game->RetrieveCaptain(ui.game->ActiveCaptain());
     if (captain->active_onion) {
       return true;
@@ -277,7 +278,7 @@ void UnpauseGame(UIState& ui) {
 }
 
 bool PauseButtonPressed(const UIState& ui) {
-  return (keysDown() & KEY_START);
+  return (input::Down() & KEY_START);
 }
 
 void UpdateOnionUI(UIState& ui) {
@@ -309,12 +310,12 @@ void UpdateOnionUI(UIState& ui) {
   printf("%d\n", abs(ui.pikmin_delta));
   printf("Pikmin in Squad: %d\n", pikmin_in_squad + ui.pikmin_delta);
 
-  if (keysHeld() & (KEY_DOWN | KEY_UP)) {
+  if (input::Held() & (KEY_DOWN | KEY_UP)) {
     if (key_repeat_active(ui.key_timer)) {
-      if ((keysHeld() & KEY_UP) and pikmin_in_squad + ui.pikmin_delta > 0) {
+      if ((input::Held() & KEY_UP) and pikmin_in_squad + ui.pikmin_delta > 0) {
         ui.pikmin_delta--;
       }
-      if ((keysHeld() & KEY_DOWN) and pikmin_in_onion - ui.pikmin_delta > 0 and ui.game->PikminInField() + ui.pikmin_delta < 100) {
+      if ((input::Held() & KEY_DOWN) and pikmin_in_onion - ui.pikmin_delta > 0 and ui.game->PikminInField() + ui.pikmin_delta < 100) {
         ui.pikmin_delta++;
       }
     }
@@ -323,10 +324,10 @@ void UpdateOnionUI(UIState& ui) {
     ui.key_timer = 0;
   }
 
-  if ((keysHeld() & KEY_TOUCH)) {
+  if ((input::Held() & KEY_TOUCH)) {
     if (key_repeat_active(ui.touch_timer)) {
       touchPosition touch;
-      touchRead(&touch);
+      touch = input::Touch();
 
       if (touch.py < 64 and pikmin_in_squad + ui.pikmin_delta > 0) {
         ui.pikmin_delta--;
@@ -342,11 +343,11 @@ void UpdateOnionUI(UIState& ui) {
 }
 
 bool CloseOnionUI(const UIState& ui) {
-  return (keysDown() & KEY_A);
+  return (input::Down() & KEY_A);
 }
 
 bool CancelOnionUI(const UIState& ui) {
-  return (keysDown() & KEY_B);
+  return (input::Down() & KEY_B);
 }
 
 void ApplyOnionDelta(UIState& ui) {
@@ -365,7 +366,7 @@ void ApplyOnionDelta(UIState& ui) {
         // Have this pikmin randomly target one of the onion's feet, and
         // set its collision group accordingly
         pikmin->body->sensor_groups = ONION_FEET_GROUP;
-        Vec3 onion_foot_position = captain->active_onion->feet[rand() % 3]->position;
+        Vec3 onion_foot_position = captain->active_onion->feet[pikmin->random.Range(3)]->position;
         pikmin->target = Vec2{onion_foot_position.x, onion_foot_position.z};
         pikmin->has_target = true;
 
@@ -383,7 +384,7 @@ void ApplyOnionDelta(UIState& ui) {
 }
 
 bool DebugButtonPressed(const UIState&  ui) {
-  return keysDown() & KEY_SELECT;
+  return input::Down() & KEY_SELECT;
 }
 
 void UpdateDebugScreen(UIState& ui) {
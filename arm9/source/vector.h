@@ -3,6 +3,7 @@
 
 #include <nds/ndstypes.h>
 
+#include "math_unit.h"
 #include "numeric_types.h"
 #include "trig.h"
 
@@ -60,7 +61,7 @@ struct Vector3 {
 
   // Warning: Only correct for 1.19.12 fixed specialization.
   Fixed<T, F> Length() const {
-    s32 root = sqrtf32((x * x + y * y + z * z).data_);
+    s32 root = math_unit::SqrtFixed((x * x + y * y + z * z).data_);
     Fixed<T, F> result;
     result.data_ = root;
     return result;
@@ -74,14 +75,44 @@ struct Vector3 {
 
   // Return a unit vector with the same orientation as this instance.
   Vector3<T, F> Normalize() const {
-    Vector3<T, F> result;
-    Fixed<T, F> current_length = Length();
-    if (current_length == Fixed<s32,12>::FromInt(0)) {
+    // Set up the numerators while the root is worked out, and store each
+    // component while the next one divides.
+    math_unit::StartSqrt((u64)(x * x + y * y + z * z).data_ << 12);
+    s64 numerator_x = (s64)x.data_ << 12;
+    s64 numerator_y = (s64)y.data_ << 12;
+    s64 numerator_z = (s64)z.data_ << 12;
+    s32 current_length = math_unit::SqrtResult();
+    if (current_length == 0) {
         return Vector3{Fixed<s32,12>::FromInt(0), Fixed<s32,12>::FromInt(0), Fixed<s32,12>::FromInt(0)};
     }
-    result.x.data_ = divf32(x.data_, current_length.data_);
-    result.y.data_ = divf32(y.data_, current_length.data_);
-    result.z.data_ = divf32(z.data_, current_length.data_);
+    Vector3<T, F> result;
+    math_unit::StartDivide(numerator_x, current_length);
+    s32 component = math_unit::DivideResult();
+    math_unit::StartDivideAgain(numerator_y);
+    result.x.data_ = component;
+    component = math_unit::DivideResult();
+    math_unit::StartDivideAgain(numerator_z);
+    result.y.data_ = component;
+    result.z.data_ = math_unit::DivideResult();
+    return result;
+  }
+
+  // Moves between the compact storage vectors below and the 32 bit vectors
+  // math is done in. Narrow doesn't check the range; anything that doesn't fit
+  // wraps.
+  Vector3<s32, F> Widen() const {
+    Vector3<s32, F> wide;
+    wide.x.data_ = x.data_;
+    wide.y.data_ = y.data_;
+    wide.z.data_ = z.data_;
+    return wide;
+  }
+
+  static Vector3<T, F> Narrow(const Vector3<s32, F>& wide) {
+    Vector3<T, F> result;
+    result.x.data_ = (T)wide.x.data_;
+    result.y.data_ = (T)wide.y.data_;
+    result.z.data_ = (T)wide.z.data_;
     return result;
   }
 };
@@ -93,7 +124,7 @@ struct Vector2 {
 
   // Warning: Only correct for 1.19.12 fixed specialization.
   Fixed<T, F> Length() const {
-    s32 root = sqrtf32((x * x + y * y).data_);
+    s32 root = math_unit::SqrtFixed((x * x + y * y).data_);
     Fixed<T, F> result;
     result.data_ = root;
     return result;
@@ -105,13 +136,20 @@ struct Vector2 {
 
   // Return a unit vector with the same orientation as this instance.
   Vector2<T, F> Normalize() const {
-    Vector2<T, F> result;
-    Fixed<T, F> current_length = Length();
-    if (current_length == Fixed<s32,12>::FromInt(0)) {
+    // Same overlapping as Vector3::Normalize
+    math_unit::StartSqrt((u64)(x * x + y * y).data_ << 12);
+    s64 numerator_x = (s64)x.data_ << 12;
+    s64 numerator_y = (s64)y.data_ << 12;
+    s32 current_length = math_unit::SqrtResult();
+    if (current_length == 0) {
         return Vector2{Fixed<s32,12>::FromInt(0), Fixed<s32,12>::FromInt(0)};
     }
-    result.x.data_ = divf32(x.data_, current_length.data_);
-    result.y.data_ = divf32(y.data_, current_length.data_);
+    Vector2<T, F> result;
+    math_unit::StartDivide(numerator_x, current_length);
+    s32 component = math_unit::DivideResult();
+    math_unit::StartDivideAgain(numerator_y);
+    result.x.data_ = component;
+    result.y.data_ = math_unit::DivideResult();
     return result;
   }
 
@@ -163,4 +201,10 @@ struct Vector2 {
 using Vec3 = Vector3<>;
 using Vec2 = Vector2<>;
 
+// Half the size of a Vec3, for storing things that never get far from zero:
+// each component is a 4.12 fixed, so the range is just under +/-8. These are
+// for storage only; Widen() into a Vec3 to do math with one, and Narrow() the
+// result to store it back.
+using CompactVec3 = Vector3<s16>;
+
 #endif  // VECTOR_H
@@ -0,0 +1,101 @@
+#include "vector_kernels.h"
+
+#include "math_unit.h"
+
+using numeric_types::fixed;
+
+namespace vector_kernels {
+
+namespace {
+
+// Squared length in 40.24, ready for the square root unit to give back a
+// 20.12 length
+inline u64 Length2(const Vec2& v) {
+  s64 sum = (s64)v.x.data_ * v.x.data_;
+  sum += (s64)v.y.data_ * v.y.data_;
+  return sum;
+}
+
+inline u64 Length2(const Vec3& v) {
+  s64 sum = (s64)v.x.data_ * v.x.data_;
+  sum += (s64)v.y.data_ * v.y.data_;
+  sum += (s64)v.z.data_ * v.z.data_;
+  return sum;
+}
+
+inline void Divide(const Vec2& v, s32 length, Vec2* direction) {
+  math_unit::StartDivide((s64)v.x.data_ << 12, length);
+  s64 numerator_y = (s64)v.y.data_ << 12;
+  s32 x = math_unit::DivideResult();
+  math_unit::StartDivideAgain(numerator_y);
+  direction->x.data_ = x;
+  direction->y.data_ = math_unit::DivideResult();
+}
+
+inline void Divide(const Vec3& v, s32 length, Vec3* direction) {
+  math_unit::StartDivide((s64)v.x.data_ << 12, length);
+  s64 numerator_y = (s64)v.y.data_ << 12;
+  s64 numerator_z = (s64)v.z.data_ << 12;
+  s32 x = math_unit::DivideResult();
+  math_unit::StartDivideAgain(numerator_y);
+  direction->x.data_ = x;
+  s32 y = math_unit::DivideResult();
+  math_unit::StartDivideAgain(numerator_z);
+  direction->y.data_ = y;
+  direction->z.data_ = math_unit::DivideResult();
+}
+
+// The divider and the root unit are independent, so vector i + 1's root is
+// started before vector i's components go through the divider.
+template <typename V>
+inline void Process(const V* vectors, int count, fixed* lengths,
+    V* directions) {
+  if (count <= 0) {
+    return;
+  }
+  math_unit::StartSqrt(Length2(vectors[0]));
+  for (int i = 0; i < count; i++) {
+    u64 next = i + 1 < count ? Length2(vectors[i + 1]) : 0;
+    s32 length = math_unit::SqrtResult();
+    if (i + 1 < count) {
+      math_unit::StartSqrt(next);
+    }
+    if (lengths) {
+      lengths[i].data_ = length;
+    }
+    if (!directions) {
+      continue;
+    }
+    if (length == 0) {
+      directions[i] = V{};
+      continue;
+    }
+    Divide(vectors[i], length, &directions[i]);
+  }
+}
+
+}  // namespace
+
+void LengthAndDirection(const Vec2* vectors, int count, fixed* lengths,
+    Vec2* directions) {
+  Process(vectors, count, lengths, directions);
+}
+
+void LengthAndDirection(const Vec3* vectors, int count, fixed* lengths,
+    Vec3* directions) {
+  Process(vectors, count, lengths, directions);
+}
+
+fixed LengthAndDirection(const Vec2& vector, Vec2* direction) {
+  fixed length;
+  LengthAndDirection(&vector, 1, &length, direction);
+  return length;
+}
+
+fixed LengthAndDirection(const Vec3& vector, Vec3* direction) {
+  fixed length;
+  LengthAndDirection(&vector, 1, &length, direction);
+  return length;
+}
+
+}  // namespace vector_kernels
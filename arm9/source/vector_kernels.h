@@ -0,0 +1,29 @@
+#ifndef VECTOR_KERNELS_H
+#define VECTOR_KERNELS_H
+
+#include "numeric_types.h"
+#include "tcm.h"
+#include "vector.h"
+
+// Length and direction of many vectors in one pass. Each vector costs one
+// square root and one divide per component, same as Normalize alone, but the
+// root for the next vector runs while this one's components divide, and the
+// squared length is accumulated at 64 bits (SMULL/SMLAL in ARM state) with a
+// single shift at the end.
+//
+// A zero vector gets a zero length and a zero direction. lengths and
+// directions may be null when only one of them is wanted.
+namespace vector_kernels {
+
+HOT_CODE void LengthAndDirection(const Vec2* vectors, int count,
+    numeric_types::fixed* lengths, Vec2* directions);
+HOT_CODE void LengthAndDirection(const Vec3* vectors, int count,
+    numeric_types::fixed* lengths, Vec3* directions);
+
+// For one vector at a time: returns the length and writes the direction
+numeric_types::fixed LengthAndDirection(const Vec2& vector, Vec2* direction);
+numeric_types::fixed LengthAndDirection(const Vec3& vector, Vec3* direction);
+
+}  // namespace vector_kernels
+
+#endif  // VECTOR_KERNELS_H
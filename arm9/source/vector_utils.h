@@ -2,26 +2,19 @@
 #define VECTOR_UTILS_H
 
 #include "numeric_types.h"
+#include "trig.h"
 #include "vector.h"
 
+// The Y rotation that faces a model along direction, which is on the XZ
+// plane and needn't be normalized. Models face +X at zero, and turn away
+// from +Z as the angle grows. A zero vector has no direction, and gets a
+// quarter turn, which is what everything facing it has always been drawn at.
 inline numeric_types::Brads AngleFromVec2(Vec2 direction) {
-  if (direction.Length().data_ > 0) {
-    direction = direction.Normalize();
-    if (direction.y.data_ <= 0) {
-      return numeric_types::Brads::Raw(acosLerp(direction.x.data_));
-    } else {
-      return numeric_types::Brads::Raw(-acosLerp(direction.x.data_));
-    }
-  }
-  return numeric_types::Brads::Raw(acosLerp(0));
-}
-
-inline numeric_types::Brads AngleFromNormalizedVec2(Vec2 direction) {
-  if (direction.y.data_ <= 0) {
-    return numeric_types::Brads::Raw(acosLerp(direction.x.data_));
-  } else {
-    return numeric_types::Brads::Raw(-acosLerp(direction.x.data_));
+  if (direction.x.data_ == 0 and direction.y.data_ == 0) {
+    return numeric_types::Brads::Raw(degreesToAngle(90));
   }
+  return trig::Atan2(numeric_types::fixed::FromRaw(-direction.y.data_),
+      direction.x);
 }
 
 #endif
@@ -0,0 +1,10 @@
+// Runs the same math microbenchmark as the "Benchmark Math" debug flag does
+// on the DS. Here math_unit falls back to plain integer math, so this mostly
+// checks that every path gives the same answers.
+
+#include "debug/math_benchmark.h"
+
+int main() {
+  debug::BenchmarkMath();
+  return 0;
+}
@@ -0,0 +1,74 @@
+// Checks trig::Atan2 against the standard library's atan2 over every brad of
+// the circle, at lengths from a single raw unit up to near the top of the
+// 20.12 range, and times it.
+//
+// Usage: bench_trig
+// Exits nonzero if any answer is off by more than kTolerance brads.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "numeric_types.h"
+#include "trig.h"
+
+using numeric_types::fixed;
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+const int kCircle = 1 << 15;
+const int kTolerance = 1;
+
+// Brads between two angles, the short way around
+int AngleError(int a, int b) {
+  int difference = (a - b) & (kCircle - 1);
+  return difference > kCircle / 2 ? kCircle - difference : difference;
+}
+
+}  // namespace
+
+int main() {
+  // Raw lengths: one unit, a pikmin's step, across a level, and far past it
+  const double kLengths[] = {1, 20, 1 << 12, 100 << 12, 400000 << 12};
+  int worst = 0;
+  for (double length : kLengths) {
+    long long total = 0;
+    int worst_here = 0;
+    int samples = 0;
+    for (int brads = 0; brads < kCircle; brads++) {
+      double radians = brads * 2.0 * kPi / kCircle;
+      s32 x = (s32)std::lround(length * std::cos(radians));
+      s32 y = (s32)std::lround(length * std::sin(radians));
+      if (x == 0 and y == 0) {
+        continue;
+      }
+      // Compare against where the rounded vector actually points
+      int expected = (int)std::lround(std::atan2((double)y, (double)x) *
+          kCircle / (2.0 * kPi));
+      int error = AngleError(
+          trig::Atan2(fixed::FromRaw(y), fixed::FromRaw(x)).data_, expected);
+      total += error;
+      worst_here = std::max(worst_here, error);
+      samples++;
+    }
+    printf("length %12.0f raw  mean error %.3f brads  worst %d\n", length,
+        (double)total / samples, worst_here);
+    worst = std::max(worst, worst_here);
+  }
+
+  const int kCalls = 1 << 20;
+  volatile s16 sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < kCalls; i++) {
+    sink = trig::Atan2(fixed::FromRaw((s32)((i * 7919) & 0x7FFFFF) - (1 << 22)),
+        fixed::FromRaw((s32)((i * 104729) & 0xFFFFFF) - (1 << 23))).data_;
+  }
+  auto end = std::chrono::steady_clock::now();
+  printf("Atan2: %.1f ns per call\n",
+      std::chrono::duration<double, std::nano>(end - start).count() / kCalls);
+  (void)sink;
+
+  return worst > kTolerance;
+}
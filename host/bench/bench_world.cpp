@@ -0,0 +1,283 @@
+// Times World::Update on a synthetic field: a swarm of pikmin following a
+// leader around rolling terrain with a plateau to run into, plus a scattering
+// of treasure, obstacles and sensors, roughly like a busy level in game.
+//
+// Before timing anything, checks that two pikmin that only just touch across
+// a swarm cell boundary are pushed apart, and fails if they aren't.
+//
+// Usage: bench_world [steps]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "debug/profiler.h"
+#include "physics/world.h"
+#include "numeric_types.h"
+#include "random.h"
+#include "vector.h"
+
+using numeric_types::fixed;
+using numeric_types::literals::operator"" _f;
+using physics::Body;
+using physics::World;
+
+namespace {
+
+const int kMapSize = 256;
+const int kTileSize = 8;
+const int kWarmupSteps = 60;
+
+// Builds a heightmap in the tiled format (see tools/image-to-heightmap.py).
+// Flat tiles are shared; everything else is stored with full byte deltas,
+// which is plenty for a benchmark.
+std::vector<u8> BuildHeightmap() {
+  std::vector<u8> cells(kMapSize * kMapSize);
+  for (int z = 0; z < kMapSize; z++) {
+    for (int x = 0; x < kMapSize; x++) {
+      int height = 24 + (int)(8.0 * std::sin(x / 18.0) * std::cos(z / 23.0));
+      // A plateau in the middle of the field, with cliffs all around it
+      if (x >= 96 and x < 160 and z >= 96 and z < 128) {
+        height = 100;
+      }
+      cells[z * kMapSize + x] = height;
+    }
+  }
+
+  const int tiles = kMapSize / kTileSize;
+  std::vector<u16> tile_map;
+  std::vector<u32> offsets;
+  std::vector<u8> tile_data;
+  std::map<int, u16> flat_tiles;
+  for (int tz = 0; tz < tiles; tz++) {
+    for (int tx = 0; tx < tiles; tx++) {
+      int low = 255;
+      int high = 0;
+      for (int i = 0; i < kTileSize * kTileSize; i++) {
+        int value = cells[(tz * kTileSize + i / kTileSize) * kMapSize +
+            tx * kTileSize + i % kTileSize];
+        low = std::min(low, value);
+        high = std::max(high, value);
+      }
+      if (low == high and flat_tiles.count(low)) {
+        tile_map.push_back(flat_tiles[low]);
+        continue;
+      }
+      u16 id = offsets.size();
+      tile_map.push_back(id);
+      offsets.push_back(tile_data.size());
+      tile_data.push_back(low);
+      if (low == high) {
+        flat_tiles[low] = id;
+        tile_data.push_back(0);
+        continue;
+      }
+      tile_data.push_back(8);
+      for (int i = 0; i < kTileSize * kTileSize; i++) {
+        tile_data.push_back(cells[(tz * kTileSize + i / kTileSize) * kMapSize +
+            tx * kTileSize + i % kTileSize] - low);
+      }
+    }
+  }
+
+  std::vector<u8> file{'H', 'M', 'T', '1'};
+  auto put16 = [&file](u16 value) {
+    file.push_back(value & 0xFF);
+    file.push_back(value >> 8);
+  };
+  auto put32 = [&put16](u32 value) {
+    put16(value & 0xFFFF);
+    put16(value >> 16);
+  };
+  put16(kMapSize);
+  put16(kMapSize);
+  put16(offsets.size());
+  put16(0);
+  for (u16 tile : tile_map) {
+    put16(tile);
+  }
+  if (tile_map.size() % 2) {
+    put16(0);
+  }
+  for (u32 offset : offsets) {
+    put32(offset);
+  }
+  file.insert(file.end(), tile_data.begin(), tile_data.end());
+  return file;
+}
+
+struct Scene {
+  std::vector<Body*> pikmin;
+  std::vector<Body*> objects;
+  Random random;
+};
+
+Vec3 RandomSpot(Random& random, int spread) {
+  return Vec3{
+    fixed::FromInt(32 + random.Range(spread)),
+    fixed::FromInt(30),
+    fixed::FromInt(32 + random.Range(spread))
+  };
+}
+
+void Populate(World& world, Scene& scene, int bodies) {
+  // One body in ten is something other than a pikmin
+  int objects = bodies / 10;
+  for (int i = 0; i < objects; i++) {
+    Body* body = world.AllocateBody();
+    body->position = RandomSpot(scene.random, 192);
+    switch (i % 3) {
+      case 0:  // Treasure: heavy, pushable
+        body->radius = 2_f;
+        body->height = 2_f;
+        body->is_movable = 1;
+        body->collision_group = TREASURE_GROUP;
+        break;
+      case 1:  // Scenery
+        body->radius = 3_f;
+        body->height = 8_f;
+        body->collision_group = ATTACK_GROUP;
+        break;
+      case 2:  // Big sensor, like an onion beam
+        body->radius = 6_f;
+        body->height = 10_f;
+        body->is_sensor = 1;
+        body->collides_with_level = 0;
+        body->affected_by_gravity = 0;
+        body->collision_group = ONION_BEAM_GROUP;
+        break;
+    }
+    scene.objects.push_back(body);
+  }
+  for (int i = objects; i < bodies; i++) {
+    Body* body = world.AllocateBody();
+    body->position = RandomSpot(scene.random, 64);
+    body->height = 6_f;
+    body->radius = 1_f;
+    body->is_pikmin = 1;
+    body->is_movable = 1;
+    body->collision_group = PIKMIN_GROUP;
+    body->sensor_groups = WHISTLE_GROUP | ATTACK_GROUP | TREASURE_GROUP;
+    scene.pikmin.push_back(body);
+  }
+}
+
+void Steer(Scene& scene, int step) {
+  // The leader circles the plateau; everyone else runs after it, bunching up
+  // the way a squad does
+  double angle = step / 300.0;
+  Vec2 leader{fixed::FromFloat(128 + 80 * std::cos(angle)),
+      fixed::FromFloat(112 + 80 * std::sin(angle))};
+  const fixed kRunSpeed = 0.3_f;
+  for (unsigned int i = 0; i < scene.pikmin.size(); i++) {
+    // Like the AI, only retarget every few frames
+    if (((i + step) & 0x3) != 0) {
+      continue;
+    }
+    Body* body = scene.pikmin[i];
+    Vec2 to_leader = leader - Vec2{body->position.x, body->position.z};
+    fixed distance = to_leader.Length();
+    if (distance < 4_f) {
+      body->velocity.x = 0_f;
+      body->velocity.z = 0_f;
+      continue;
+    }
+    Vec2 velocity = to_leader.Normalize() * kRunSpeed;
+    body->velocity.x = velocity.x;
+    body->velocity.z = velocity.y;
+  }
+}
+
+void Run(int bodies, int steps, const std::vector<u8>& heightmap) {
+  // Every World registers its own profiler topics; only report this one's
+  auto& topics = debug::Profiler::Topics();
+  const unsigned int first_topic = topics.size();
+  World* world = new World();
+  world->Reserve(bodies);
+  world->SetHeightmap(heightmap.data());
+  Scene scene;
+  Populate(*world, scene, bodies);
+
+  for (int step = 0; step < kWarmupSteps; step++) {
+    Steer(scene, step);
+    world->Update();
+  }
+
+  std::vector<double> topic_totals(topics.size(), 0.0);
+  double total = 0.0;
+  double worst = 0.0;
+  for (int step = kWarmupSteps; step < kWarmupSteps + steps; step++) {
+    Steer(scene, step);
+    auto start = std::chrono::steady_clock::now();
+    world->Update();
+    auto end = std::chrono::steady_clock::now();
+    double micros = std::chrono::duration<double, std::micro>(end - start).count();
+    total += micros;
+    worst = std::max(worst, micros);
+    for (unsigned int t = first_topic; t < topics.size(); t++) {
+      topic_totals[t] += topics[t].timing.delta() / 1000.0;
+    }
+  }
+
+  printf("bodies %4d  steps %d  update %8.2f us avg  %8.2f us worst  checksum %08x\n",
+      bodies, steps, total / steps, worst, (unsigned)world->Checksum());
+  for (unsigned int t = first_topic; t < topics.size(); t++) {
+    printf("  %-32s %8.2f us\n", topics[t].name.c_str(), topic_totals[t] / steps);
+  }
+  printf("  %-32s %8d\n", "Sleeping bodies", world->SleepingBodies());
+  printf("  %-32s %8d\n", "Contacts", world->Contacts());
+
+  delete world;
+}
+
+bool CheckSwarmSeparation(const std::vector<u8>& heightmap) {
+  // Pikmin are a unit in radius and 1.9 units apart, on either side of
+  // x = 64, which is a boundary whatever size the swarm cells are
+  World* world = new World();
+  world->SetHeightmap(heightmap.data());
+  Body* pikmin[2];
+  const fixed kStart[2] = {62.95_f, 64.85_f};
+  for (int i = 0; i < 2; i++) {
+    pikmin[i] = world->AllocateBody();
+    pikmin[i]->position = Vec3{kStart[i], 30_f, 32.5_f};
+    pikmin[i]->height = 6_f;
+    pikmin[i]->radius = 1_f;
+    pikmin[i]->is_pikmin = 1;
+    pikmin[i]->is_movable = 1;
+    pikmin[i]->collision_group = PIKMIN_GROUP;
+  }
+  for (int step = 0; step < 30; step++) {
+    world->Update();
+  }
+  fixed distance = (Vec2{pikmin[1]->position.x, pikmin[1]->position.z} -
+      Vec2{pikmin[0]->position.x, pikmin[0]->position.z}).Length();
+  delete world;
+  if (distance < 1.95_f) {
+    printf("FAILED: touching pikmin across a swarm cell boundary are still "
+        "%.3f apart\n", (float)distance);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int steps = 2000;
+  if (argc > 1) {
+    steps = atoi(argv[1]);
+  }
+  std::vector<u8> heightmap = BuildHeightmap();
+  if (not CheckSwarmSeparation(heightmap)) {
+    return 1;
+  }
+  const int kBodyCounts[] = {100, 256, 1024};
+  for (int bodies : kBodyCounts) {
+    Run(bodies, steps, heightmap);
+  }
+  return 0;
+}
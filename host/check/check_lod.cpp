@@ -0,0 +1,155 @@
+// Loads a made-up DSGX file with a few level of detail chains and checks that
+// Dsgx::CollectLevelsOfDetail links them up, and that Mesh::DetailAt walks them
+// the way Drawable::ChooseDetail expects. Exits non-zero on the first failure.
+//
+// Usage: check_lod
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "dsgx.h"
+#include "numeric_types.h"
+#include "project_settings.h"
+
+using numeric_types::fixed;
+using numeric_types::literals::operator"" _f;
+
+namespace {
+
+int failures = 0;
+
+void Check(bool condition, const char* what) {
+  if (not condition) {
+    printf("FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// Writes chunks the way the Blender exporter does: a four character tag, the
+// length in words, then the words themselves. Names take eight words.
+class DsgxWriter {
+ public:
+  void Name(const std::string& name) {
+    u32 words[8] = {0};
+    strncpy((char*)words, name.c_str(), sizeof(words) - 1);
+    chunk_.insert(chunk_.end(), words, words + 8);
+  }
+
+  void Word(u32 word) {
+    chunk_.push_back(word);
+  }
+
+  void EndChunk(const char* tag) {
+    u32 header;
+    memcpy(&header, tag, 4);
+    data_.push_back(header);
+    data_.push_back(chunk_.size());
+    data_.insert(data_.end(), chunk_.begin(), chunk_.end());
+    chunk_.clear();
+  }
+
+  // A mesh with an empty display list and a bounding sphere of this radius
+  void Mesh(const std::string& name, int radius) {
+    Name(name);
+    Word(0);
+    EndChunk("DSGX");
+    Name(name);
+    Word(0);
+    Word(0);
+    Word(0);
+    Word(fixed::FromInt(radius).data_);
+    EndChunk("BSPH");
+  }
+
+  // An animation with no channels to speak of, for just this mesh
+  void Animation(const std::string& mesh, const std::string& name) {
+    Name("vertex");
+    Name(mesh);
+    Word(0);
+    EndChunk("AREF");
+    Name(name);
+    Name("vertex");
+    Name(mesh);
+    Word(1);
+    Word(1);
+    EndChunk("ANIM");
+  }
+
+  std::vector<u32>& data() {
+    return data_;
+  }
+
+ private:
+  std::vector<u32> chunk_;
+  std::vector<u32> data_;
+};
+
+}  // namespace
+
+int main() {
+  DsgxWriter writer;
+  writer.Mesh("red_pikmin", 2);
+  writer.Mesh("red_pikmin_lod1", 2);
+  writer.Mesh("red_pikmin_lod2", 2);
+  writer.Animation("red_pikmin", "Run");
+  writer.Animation("red_pikmin_lod1", "Run");
+  // A mesh whose name only happens to contain "_lod"
+  writer.Mesh("x_lodge", 4);
+  writer.Mesh("x_lodge_lod1", 4);
+  // Not a level number, so these are meshes in their own right
+  writer.Mesh("tree_lod", 1);
+  writer.Mesh("tree_lodx", 1);
+
+  auto& data = writer.data();
+  Dsgx dsgx(data.data(), data.size() * sizeof(u32));
+
+  Mesh* red = dsgx.MeshByName("red_pikmin");
+  Mesh* red1 = dsgx.MeshByName("red_pikmin_lod1");
+  Mesh* red2 = dsgx.MeshByName("red_pikmin_lod2");
+  Mesh* lodge = dsgx.MeshByName("x_lodge");
+  Mesh* lodge1 = dsgx.MeshByName("x_lodge_lod1");
+  Mesh* tree = dsgx.MeshByName("tree_lod");
+  Mesh* treex = dsgx.MeshByName("tree_lodx");
+  if (not (red and red1 and red2 and lodge and lodge1 and tree and treex)) {
+    printf("FAILED: meshes didn't load\n");
+    return 1;
+  }
+
+  // Chains, and how far out each level takes over
+  const fixed step = fixed::FromInt(2 * LOD_DISTANCE_PER_RADIUS);
+  Check(red->lower_detail == red1, "red_pikmin steps down to _lod1");
+  Check(red1->lower_detail == red2, "red_pikmin_lod1 steps down to _lod2");
+  Check(red2->lower_detail == nullptr, "red_pikmin_lod2 is the last level");
+  Check(red->lower_detail_depth == step, "_lod1 takes over one step out");
+  Check(red1->lower_detail_depth == step * 2_f, "_lod2 takes over two out");
+  Check(lodge->lower_detail == lodge1, "x_lodge gets its own chain");
+  Check(tree->lower_detail == nullptr and treex->lower_detail == nullptr,
+      "names without a level number aren't levels");
+
+  // Walking the chain without an animation
+  ::Animation* none = nullptr;
+  Check(red->DetailAt(step - 1_f, &none) == red, "full detail up close");
+  Check(red->DetailAt(step + 1_f, &none) == red1, "_lod1 past one step");
+  Check(red->DetailAt(step * 3_f, &none) == red2, "_lod2 far out");
+
+  // With one: _lod1 has Run too, _lod2 doesn't, so the walk stops at _lod1
+  ::Animation* run = &red->animations["Run"];
+  Check(red->animations["Run"].lower_detail == &red1->animations["Run"],
+      "Run is linked to the same animation one level down");
+  ::Animation* playing = run;
+  Check(red->DetailAt(step + 1_f, &playing) == red1 and
+      playing == &red1->animations["Run"], "animation follows the level");
+  playing = run;
+  Check(red->DetailAt(step * 3_f, &playing) == red1 and
+      playing == &red1->animations["Run"],
+      "stops at the last level with the animation");
+
+  if (failures) {
+    return 1;
+  }
+  printf("check_lod: ok\n");
+  return 0;
+}
@@ -0,0 +1,20 @@
+// Host stand-in for libnds, covering only what the simulation core (physics,
+// fixed point math, the profiler) needs to build and run on a PC. See
+// "Host benchmark" in README.md.
+#ifndef HOST_NDS_H
+#define HOST_NDS_H
+
+#include <nds/ndstypes.h>
+#include <nds/arm9/math.h>
+#include <nds/arm9/trig_lut.h>
+#include <nds/arm9/video.h>
+#include <nds/arm9/videoGL.h>
+
+// Timing is in nanoseconds of wall clock time rather than bus cycles
+void cpuStartTiming(int timer);
+u32 cpuGetTiming();
+u32 cpuEndTiming();
+
+void nocashMessage(const char* message);
+
+#endif  // HOST_NDS_H
@@ -0,0 +1,23 @@
+// Host stand-in for libnds' math.h. The DS does these on its divide and
+// square root units; here they're plain integer math with the same results.
+#ifndef HOST_NDS_ARM9_MATH_H
+#define HOST_NDS_ARM9_MATH_H
+
+#include <nds/ndstypes.h>
+
+#define inttof32(n) ((n) << 12)
+#define f32toint(n) ((n) >> 12)
+#define floattof32(n) ((s32)((n) * (1 << 12)))
+#define f32tofloat(n) (((float)(n)) / (float)(1 << 12))
+
+s32 divf32(s32 num, s32 den);
+s32 mulf32(s32 a, s32 b);
+s32 sqrtf32(s32 a);
+s32 div32(s32 num, s32 den);
+s32 mod32(s32 num, s32 den);
+s32 div64(s64 num, s32 den);
+s32 mod64(s64 num, s32 den);
+u32 sqrt32(int a);
+u32 sqrt64(long long a);
+
+#endif  // HOST_NDS_ARM9_MATH_H
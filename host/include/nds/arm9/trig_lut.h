@@ -0,0 +1,18 @@
+// Host stand-in for libnds' trig_lut.h. Angles are 32768 to a circle and
+// results are 4.12 fixed point, as on the DS.
+#ifndef HOST_NDS_ARM9_TRIG_LUT_H
+#define HOST_NDS_ARM9_TRIG_LUT_H
+
+#include <nds/ndstypes.h>
+
+#define DEGREES_IN_CIRCLE (1 << 15)
+#define degreesToAngle(degrees) ((degrees) * DEGREES_IN_CIRCLE / 360)
+#define angleToDegrees(angle) ((angle) * 360 / DEGREES_IN_CIRCLE)
+
+s16 sinLerp(s16 angle);
+s16 cosLerp(s16 angle);
+s32 tanLerp(s16 angle);
+s16 asinLerp(s16 par);
+s16 acosLerp(s16 par);
+
+#endif  // HOST_NDS_ARM9_TRIG_LUT_H
@@ -0,0 +1,10 @@
+// Host stand-in for libnds' video.h
+#ifndef HOST_NDS_ARM9_VIDEO_H
+#define HOST_NDS_ARM9_VIDEO_H
+
+#include <nds/ndstypes.h>
+
+#define RGB15(r, g, b) ((r) | ((g) << 5) | ((b) << 10))
+#define RGB5(r, g, b) ((r) | ((g) << 5) | ((b) << 10))
+
+#endif  // HOST_NDS_ARM9_VIDEO_H
@@ -0,0 +1,28 @@
+// Host stand-in for libnds' videoGL.h. Nothing is drawn on the host; this only
+// exists so that headers mentioning the GL types still compile.
+#ifndef HOST_NDS_ARM9_VIDEOGL_H
+#define HOST_NDS_ARM9_VIDEOGL_H
+
+#include <nds/ndstypes.h>
+
+typedef s16 v16;
+typedef s16 t16;
+typedef s16 v10;
+
+typedef struct m4x4 {
+  s32 m[16];
+} m4x4;
+
+enum GL_TEXTURE_TYPE_ENUM {
+  GL_NOTEXTURE = 0,
+  GL_RGB32_A3 = 1,
+  GL_RGB4 = 2,
+  GL_RGB16 = 3,
+  GL_RGB256 = 4,
+  GL_COMPRESSED = 5,
+  GL_RGB8_A5 = 6,
+  GL_RGBA = 7,
+  GL_RGB = 8
+};
+
+#endif  // HOST_NDS_ARM9_VIDEOGL_H
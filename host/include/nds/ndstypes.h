@@ -0,0 +1,31 @@
+// Host stand-in for libnds' ndstypes.h: just the types and macros the
+// simulation core uses.
+#ifndef HOST_NDS_NDSTYPES_H
+#define HOST_NDS_NDSTYPES_H
+
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+typedef volatile u8 vu8;
+typedef volatile u16 vu16;
+typedef volatile u32 vu32;
+
+typedef u16 rgb;
+
+#define BIT(n) (1 << (n))
+
+// Code and data placement is meaningless off the DS
+#define ITCM_CODE
+#define DTCM_DATA
+#define DTCM_BSS
+#define ARM_CODE
+
+#endif  // HOST_NDS_NDSTYPES_H
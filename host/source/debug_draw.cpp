@@ -0,0 +1,6 @@
+// The World can draw its bodies for debugging; on the host there's nowhere to
+// draw them, so these do nothing.
+#include "debug/utilities.h"
+
+void debug::DrawCircle(Vec3, numeric_types::fixed, rgb, u32) {
+}
@@ -0,0 +1,107 @@
+// Host implementations of the libnds functions declared under include/.
+#include <nds.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+u64 IntegerSqrt(u64 value) {
+  u64 root = (u64)std::sqrt((double)value);
+  // Double precision can be off by one either way for large inputs
+  while (root * root > value) {
+    root--;
+  }
+  while ((root + 1) * (root + 1) <= value) {
+    root++;
+  }
+  return root;
+}
+
+const double kPi = 3.14159265358979323846;
+
+double AngleToRadians(s16 angle) {
+  return (double)angle * 2.0 * kPi / DEGREES_IN_CIRCLE;
+}
+
+u32 g_timer_start = 0;
+
+u32 Nanoseconds() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return (u32)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+}  // namespace
+
+s32 divf32(s32 num, s32 den) {
+  return (s32)(((s64)num << 12) / den);
+}
+
+s32 mulf32(s32 a, s32 b) {
+  return (s32)(((s64)a * b) >> 12);
+}
+
+s32 sqrtf32(s32 a) {
+  return (s32)IntegerSqrt((u64)a << 12);
+}
+
+s32 div32(s32 num, s32 den) {
+  return num / den;
+}
+
+s32 mod32(s32 num, s32 den) {
+  return num % den;
+}
+
+s32 div64(s64 num, s32 den) {
+  return (s32)(num / den);
+}
+
+s32 mod64(s64 num, s32 den) {
+  return (s32)(num % den);
+}
+
+u32 sqrt32(int a) {
+  return (u32)IntegerSqrt((u32)a);
+}
+
+u32 sqrt64(long long a) {
+  return (u32)IntegerSqrt((u64)a);
+}
+
+s16 sinLerp(s16 angle) {
+  return (s16)std::lround(std::sin(AngleToRadians(angle)) * 4096.0);
+}
+
+s16 cosLerp(s16 angle) {
+  return (s16)std::lround(std::cos(AngleToRadians(angle)) * 4096.0);
+}
+
+s32 tanLerp(s16 angle) {
+  return (s32)std::lround(std::tan(AngleToRadians(angle)) * 4096.0);
+}
+
+s16 asinLerp(s16 par) {
+  return (s16)std::lround(std::asin(par / 4096.0) * DEGREES_IN_CIRCLE / (2.0 * kPi));
+}
+
+s16 acosLerp(s16 par) {
+  return (s16)std::lround(std::acos(par / 4096.0) * DEGREES_IN_CIRCLE / (2.0 * kPi));
+}
+
+void cpuStartTiming(int) {
+  g_timer_start = Nanoseconds();
+}
+
+u32 cpuGetTiming() {
+  return Nanoseconds() - g_timer_start;
+}
+
+u32 cpuEndTiming() {
+  return cpuGetTiming();
+}
+
+void nocashMessage(const char* message) {
+  fputs(message, stderr);
+}
@@ -106,6 +106,12 @@ def spawn_commands_from_blendfile(filename):
 
     commands = []
 
+    # Levels can size the physics world to suit them with a "physics_bodies"
+    # property on the scene. This has to come before anything is spawned.
+    scene = bpy.context.scene
+    if "physics_bodies" in scene:
+        commands.append(level_command("bodies", int(scene["physics_bodies"])))
+
     # For now: assume a heightmap exists which matches the level name
     commands.append(level_command("heightmap", level_name))
 
@@ -16,22 +16,87 @@ def main(args):
   pixels = source.load()
   (width,height) = source.size
 
-  output = bytes()
-
-  output += struct.pack("<II", width, height)
-
+  cells = []
   for y in range(0,height):
     for x in range(0,width):
       r,g,b = pixels[x,y][:3]
       # Note: Blender exports heightmaps normalized to 0-127 for whatever reason, instead of
       # from 0-255 as one might expect. This is why our adjusted max here is 127, instead of 255.
       greyscale_value = min(max(0, int((r + g + b) / 3)), 127)
-      output += struct.pack("<B", greyscale_value)
+      cells.append(greyscale_value)
+
+  output = encode_tiled(cells, width, height)
 
   output_file = open(output_filename, "wb")
   output_file.write(output)
   output_file.close()
 
+# Tiled format, read by physics::Heightmap (all values little endian):
+#   u32 magic "HMT1", u16 width, u16 height, u16 unique tile count, u16 zero
+#   u16 tile map, one dictionary index per tile in row order, padded to 4 bytes
+#   u32 offset of each unique tile into the tile data
+#   tile data: u8 base, u8 bits per cell (0, 1, 2, 4 or 8), then 64 deltas
+#   from base, packed lowest bits first
+TILE_SIZE = 8
+
+def encode_tiled(cells, width, height):
+  tiles_x = (width + TILE_SIZE - 1) // TILE_SIZE
+  tiles_z = (height + TILE_SIZE - 1) // TILE_SIZE
+
+  dictionary = {}
+  tile_data = []
+  tile_map = []
+  for tz in range(0, tiles_z):
+    for tx in range(0, tiles_x):
+      # Tiles hanging off the edge repeat the last row / column
+      values = []
+      for y in range(0, TILE_SIZE):
+        for x in range(0, TILE_SIZE):
+          cx = min(tx * TILE_SIZE + x, width - 1)
+          cy = min(tz * TILE_SIZE + y, height - 1)
+          values.append(cells[cy * width + cx])
+      encoded = encode_tile(values)
+      if encoded not in dictionary:
+        dictionary[encoded] = len(tile_data)
+        tile_data.append(encoded)
+      tile_map.append(dictionary[encoded])
+
+  if len(tile_data) >= 0xFFFF:
+    sys.exit("Heightmap has too many distinct tiles (%d)" % len(tile_data))
+
+  output = bytes()
+  output += b"HMT1"
+  output += struct.pack("<HHHH", width, height, len(tile_data), 0)
+  for tile in tile_map:
+    output += struct.pack("<H", tile)
+  if len(tile_map) % 2 == 1:
+    output += struct.pack("<H", 0)
+  offset = 0
+  for tile in tile_data:
+    output += struct.pack("<I", offset)
+    offset += len(tile)
+  for tile in tile_data:
+    output += tile
+  return output
+
+def encode_tile(values):
+  base = min(values)
+  spread = max(values) - base
+  bits = 8
+  for candidate in [0, 1, 2, 4]:
+    if spread < (1 << candidate):
+      bits = candidate
+      break
+
+  output = struct.pack("<BB", base, bits)
+  if bits > 0:
+    per_byte = 8 // bits
+    packed = [0] * (len(values) // per_byte)
+    for i, value in enumerate(values):
+      packed[i // per_byte] |= (value - base) << ((i % per_byte) * bits)
+    output += bytes(packed)
+  return output
+
 def valid_command_line_arguments(args):
     return 2 <= len(args) <= 3
 